@@ -171,6 +171,21 @@ public:
 		}
 	}
 
+	// only host visible buffers can be mapped, data written to the mapped memory is flushed on unmap
+	void* map()
+	{
+		VKTE_ASSERT(!device_local, "vkte: Cannot map device local buffer!");
+		void* mapped_mem;
+		vmaMapMemory(vmc.va, vmaa, &mapped_mem);
+		return mapped_mem;
+	}
+
+	void unmap()
+	{
+		vmaFlushAllocation(vmc.va, vmaa, 0, VK_WHOLE_SIZE);
+		vmaUnmapMemory(vmc.va, vmaa);
+	}
+
 	template<class T>
 	std::vector<T> obtain_data(std::size_t element_count)
 	{
@@ -3,6 +3,7 @@
 #include "vulkan/vulkan.hpp"
 #include "vkte/buffer.hpp"
 #include "vkte/image.hpp"
+#include "vkte/spirv_reflection.hpp"
 #include "vkte/vulkan_main_context.hpp"
 
 namespace vkte
@@ -13,6 +14,8 @@ public:
 	DescriptorSetHandler(const VulkanMainContext& vmc, uint32_t set_count);
 	// first, describe the whole layout of the descriptor set
 	void add_binding(uint32_t binding, vk::DescriptorType type, vk::ShaderStageFlags stages, uint32_t descriptor_count = 1);
+	// or add all bindings of one set of a reflected pipeline, e.g. Pipeline::get_reflection()
+	void add_bindings(const ShaderReflection& reflection, uint32_t set = 0);
 	// second, add the descriptors to each set
 	void add_descriptor(uint32_t set, uint32_t binding, const std::vector<Image>& images);
 	void add_descriptor(uint32_t set, uint32_t binding, const Image& image);
@@ -37,7 +40,7 @@ private:
 	const VulkanMainContext& vmc;
 	std::vector<Descriptor> descriptors;
 	uint32_t set_count;
-	// those are all the same layout to allocate multiple descriptor sets at once
+	// those are all the same layout from the layout cache to allocate multiple descriptor sets at once
 	std::vector<vk::DescriptorSetLayout> layouts;
 	vk::DescriptorPool pool;
 	std::vector<vk::DescriptorSet> sets;
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <array>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+#include "vulkan/vulkan.hpp"
+#include "vulkan/vulkan_hash.hpp"
+
+namespace vkte
+{
+// shares descriptor set layouts with identical bindings between descriptor set handlers and pipelines
+// all bindings are partially bound, so layouts from the cache are compatible with the ones of DescriptorSetHandler
+// layouts are reference counted and destroyed with the last release
+class DescriptorSetLayoutCache
+{
+public:
+	DescriptorSetLayoutCache() = default;
+	void construct(const vk::Device& device);
+	void destruct();
+	vk::DescriptorSetLayout acquire(const std::vector<vk::DescriptorSetLayoutBinding>& bindings);
+	void release(vk::DescriptorSetLayout layout);
+	// hash of the bindings of a layout from the cache, unlike the handle it cannot be reused for a layout with different bindings
+	// empty for layouts that were not created by the cache
+	std::optional<uint64_t> get_binding_hash(vk::DescriptorSetLayout layout) const;
+	uint32_t get_layout_count() const;
+
+private:
+	// binding, descriptor type, descriptor count and stage flags of each binding in order
+	using Key = std::vector<std::array<uint32_t, 4>>;
+	struct Entry
+	{
+		vk::DescriptorSetLayout layout;
+		uint32_t ref_count;
+	};
+
+	vk::Device device;
+	mutable std::mutex mutex;
+	std::map<Key, Entry> layouts;
+	std::unordered_map<vk::DescriptorSetLayout, Key> layout_keys;
+};
+} // namespace vkte
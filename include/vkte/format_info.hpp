@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstdint>
+#include "vulkan/vulkan.hpp"
+
+namespace vkte
+{
+enum class ComponentType
+{
+	UNorm,
+	SNorm,
+	UInt,
+	SInt,
+	SFloat,
+	SRGB,
+	// packed, block compressed and depth stencil formats that cannot be processed per component
+	Opaque
+};
+
+struct FormatInfo
+{
+	// byte size of one texel block, for uncompressed formats a block is one texel
+	uint32_t block_byte_size;
+	uint32_t block_width;
+	uint32_t block_height;
+	uint32_t component_count;
+	ComponentType component_type;
+	vk::ImageAspectFlags aspect;
+};
+
+const FormatInfo& get_format_info(vk::Format format);
+// tightly packed byte size of one layer of an image with the given format
+vk::DeviceSize get_image_byte_size(vk::Format format, uint32_t width, uint32_t height, uint32_t depth = 1);
+// byte size of one texel of a single aspect as it is laid out in buffer copies
+uint32_t get_aspect_texel_byte_size(vk::Format format, vk::ImageAspectFlagBits aspect);
+} // namespace vkte
@@ -1,5 +1,10 @@
 #pragma once
 
+#include <functional>
+#include <optional>
+#include <span>
+#include "vkte/pixel_conversion.hpp"
+#include "vkte/readback_ring.hpp"
 #include "vkte/vulkan_command_context.hpp"
 #include "vk_mem_alloc.h"
 
@@ -12,6 +17,16 @@ struct ImageSubresourceRangeDesc
 	uint32_t level_count = 1;
 	uint32_t base_array_layer = 0;
 	uint32_t layer_count = 1;
+	bool operator==(const ImageSubresourceRangeDesc& other) const = default;
+};
+
+struct ImageViewDesc
+{
+	vk::ImageViewType type = vk::ImageViewType::e2D;
+	// eUndefined uses the format of the image
+	vk::Format format = vk::Format::eUndefined;
+	ImageSubresourceRangeDesc range{};
+	bool operator==(const ImageViewDesc& other) const = default;
 };
 
 struct ImageTransitionDesc
@@ -32,46 +47,113 @@ bool has_stencil(vk::Format depth_format);
 vk::ImageAspectFlags default_aspect_for_format(vk::Format format);
 void perform_image_layout_transition(vk::CommandBuffer& cb, const ImageTransitionDesc& t);
 void perform_image_layout_transition(vk::CommandBuffer& cb, const std::vector<ImageTransitionDesc>& transitions);
+void perform_image_barriers(vk::CommandBuffer& cb, const std::vector<vk::ImageMemoryBarrier2>& barriers);
 void blit_image(vk::CommandBuffer& cb, vk::Image& src, uint32_t src_mip_map_lvl, vk::Offset3D src_offset, vk::Image& dst, uint32_t dst_mip_map_lvl, vk::Offset3D dst_offset, uint32_t layer_count);
 void copy_image(vk::CommandBuffer& cb, vk::Image& src, vk::Image& dst, uint32_t width, uint32_t height, uint32_t layer_count);
 
 class Image
 {
 public:
+	static constexpr vk::DeviceSize default_staging_byte_size = 64 * 1024 * 1024;
+
+	// the constructors that upload raw data record into the open upload batch of vcc if there is one
+	// in that case the image must not be used before VulkanCommandContext::submit_upload_batch() was called
+	// if the device supports host image copy, the data is written into the image on the CPU without recording any commands
 	// used to create texture from raw data
 	Image(const VulkanMainContext& vmc, VulkanCommandContext& vcc, const unsigned char* data, uint32_t width, uint32_t height, bool use_mip_maps, uint32_t base_mip_map_lvl, Queues queues, vk::ImageUsageFlags usage_flags);
+	// used to create texture from raw data of the given format, the data has to be tightly packed
+	// the conversion is applied while the data is written to the staging buffer, the data has to be in the source layout of the conversion
+	Image(const VulkanMainContext& vmc, VulkanCommandContext& vcc, const void* data, vk::Format format, uint32_t width, uint32_t height, bool use_mip_maps, uint32_t base_mip_map_lvl, Queues queues, vk::ImageUsageFlags usage_flags, PixelConversion conversion = PixelConversion::None);
 	// used to create texture array from raw data
 	Image(const VulkanMainContext& vmc, VulkanCommandContext& vcc, const std::vector<std::vector<unsigned char>>& data, uint32_t width, uint32_t height, bool use_mip_maps, uint32_t base_mip_map_lvl, Queues queues, vk::ImageUsageFlags usage_flags, vk::ImageViewType image_view_type = vk::ImageViewType::e2D);
+	// used to create texture array from raw data without copying the layers, each layer is written directly into the staging buffer
+	Image(const VulkanMainContext& vmc, VulkanCommandContext& vcc, std::span<const std::span<const unsigned char>> layers, uint32_t width, uint32_t height, bool use_mip_maps, uint32_t base_mip_map_lvl, Queues queues, vk::ImageUsageFlags usage_flags, vk::ImageViewType image_view_type = vk::ImageViewType::e2D);
+	Image(const VulkanMainContext& vmc, VulkanCommandContext& vcc, std::span<const std::span<const unsigned char>> layers, vk::Format format, uint32_t width, uint32_t height, bool use_mip_maps, uint32_t base_mip_map_lvl, Queues queues, vk::ImageUsageFlags usage_flags, vk::ImageViewType image_view_type = vk::ImageViewType::e2D, PixelConversion conversion = PixelConversion::None);
+	// used to create 3D texture, the volume is uploaded in slabs of z slices through a staging buffer of at most staging_byte_size bytes
+	// load_slices has to write the tightly packed texels of slice_count slices starting at first_slice to dst
+	// every slab is submitted on its own, an open upload batch of vcc is submitted together with the first slab
+	Image(const VulkanMainContext& vmc, VulkanCommandContext& vcc, const std::function<void(uint32_t first_slice, uint32_t slice_count, unsigned char* dst)>& load_slices, vk::Format format, vk::Extent3D extent, bool use_mip_maps, Queues queues, vk::ImageUsageFlags usage_flags, vk::DeviceSize staging_byte_size = default_staging_byte_size);
+	// used to create 3D texture from raw data of the given format, the slices have to be tightly packed
+	Image(const VulkanMainContext& vmc, VulkanCommandContext& vcc, const void* data, vk::Format format, vk::Extent3D extent, bool use_mip_maps, Queues queues, vk::ImageUsageFlags usage_flags, vk::DeviceSize staging_byte_size = default_staging_byte_size);
 	// used to create depth buffer and multisampling color attachment
-	Image(const VulkanMainContext& vmc, const VulkanCommandContext& vcc, uint32_t width, uint32_t height, vk::ImageUsageFlags usage, vk::Format format, vk::SampleCountFlagBits sample_count, bool use_mip_maps, uint32_t base_mip_map_lvl, Queues queues, bool image_view_required = true, uint32_t layer_count = 1);
+	// images with the sparse binding flag are created without memory, the memory has to be bound by the owner (e.g. SparseImage)
+	// images with the transient attachment usage are placed in lazily allocated memory if the device has it
+	// their contents must never leave the render pass, i.e. they are cleared or not loaded and never stored
+	Image(const VulkanMainContext& vmc, const VulkanCommandContext& vcc, uint32_t width, uint32_t height, vk::ImageUsageFlags usage, vk::Format format, vk::SampleCountFlagBits sample_count, bool use_mip_maps, uint32_t base_mip_map_lvl, Queues queues, bool image_view_required = true, uint32_t layer_count = 1, vk::ImageCreateFlags create_flags = {});
 	void create_sampler(vk::Filter filter = vk::Filter::eLinear, vk::SamplerAddressMode sampler_address_mode = vk::SamplerAddressMode::eRepeat, bool enable_anisotropy = true);
 	void destruct();
 	void transition_image_layout(VulkanCommandContext& vcc, vk::ImageLayout new_layout, vk::PipelineStageFlags2 src_stage_flags, vk::PipelineStageFlags2 dst_stage_flags, vk::AccessFlags2 src_access_flags, vk::AccessFlags2 dst_access_flags);
+	// prepare the whole image or a subresource range for an access, the layout and last access of every subresource is tracked so that only required barriers are recorded
+	void require(vk::CommandBuffer& cb, vk::ImageLayout new_layout, vk::PipelineStageFlags2 stage, vk::AccessFlags2 access);
+	void require(vk::CommandBuffer& cb, vk::ImageLayout new_layout, vk::PipelineStageFlags2 stage, vk::AccessFlags2 access, const ImageSubresourceRangeDesc& range);
+	// append the required barriers instead of recording them, used to batch the barriers of multiple images
+	void require(std::vector<vk::ImageMemoryBarrier2>& barriers, vk::ImageLayout new_layout, vk::PipelineStageFlags2 stage, vk::AccessFlags2 access, const ImageSubresourceRangeDesc& range);
+	// record a copy of the first mip level of all layers into the next slot of the readback ring
+	// the data can be obtained from the handle after the command buffer was submitted and the fence or timeline value got signaled
+	ReadbackHandle read_async(vk::CommandBuffer& cb, ReadbackRing& ring, vk::Fence fence);
+	ReadbackHandle read_async(vk::CommandBuffer& cb, ReadbackRing& ring, vk::Semaphore timeline, uint64_t timeline_value);
 	VmaAllocation get_allocation() const;
 	VmaAllocationInfo get_allocation_info() const;
 	vk::DeviceSize get_byte_size() const;
 	uint32_t get_layer_count() const;
+	vk::Extent3D get_extent() const;
+	// layout of the first mip level of the first layer
 	vk::ImageLayout get_layout() const;
+	vk::ImageLayout get_layout(uint32_t mip_level, uint32_t array_layer) const;
+	ImageSubresourceRangeDesc get_full_range() const;
 	vk::Image& get_image();
 	vk::ImageView get_view() const;
+	// views of parts of the image (e.g. single mip levels or cube faces) are created on first use and destroyed with the image
+	vk::ImageView get_view(const ImageViewDesc& desc);
 	vk::Sampler get_sampler() const;
 
 private:
 	const VulkanMainContext& vmc;
 	vk::Format format = vk::Format::eR8G8B8A8Unorm;
-	int w, h, c;
+	int w, h;
+	// depth of 3D images, 2D images have a depth of 1
+	int d = 1;
 	uint32_t mip_levels;
 	uint32_t layer_count;
 	vk::DeviceSize byte_size;
-	vk::ImageLayout layout;
 	vk::Image image;
 	VmaAllocation vmaa;
 	vk::ImageView view;
+	std::vector<std::pair<ImageViewDesc, vk::ImageView>> cached_views;
 	vk::Sampler sampler;
 
-	std::pair<vk::Image, VmaAllocation> create_image(Queues queues, vk::ImageUsageFlags usage, vk::SampleCountFlagBits sample_count, bool use_mip_levels, vk::Format format, vk::Extent3D extent, uint32_t layer_count, const VmaAllocator& va, bool host_visible = false);
-	void create_image_from_data(const unsigned char* data, VulkanCommandContext& vcc, Queues queues, uint32_t base_mip_map_lvl, vk::ImageUsageFlags usage_flags, vk::ImageViewType image_view_type = vk::ImageViewType::e2D);
+	struct SubresourceState
+	{
+		vk::ImageLayout layout = vk::ImageLayout::eUndefined;
+		// last write (or layout transition) that following accesses have to wait for
+		vk::PipelineStageFlags2 write_stage = vk::PipelineStageFlagBits2::eNone;
+		vk::AccessFlags2 write_access = vk::AccessFlagBits2::eNone;
+		// reads that already wait for the last write
+		vk::PipelineStageFlags2 read_stages = vk::PipelineStageFlagBits2::eNone;
+		vk::AccessFlags2 read_access = vk::AccessFlagBits2::eNone;
+	};
+	// indexed by array_layer * mip_levels + mip_level
+	std::vector<SubresourceState> subresource_states;
+
+	std::pair<vk::Image, VmaAllocation> create_image(Queues queues, vk::ImageUsageFlags usage, vk::SampleCountFlagBits sample_count, bool use_mip_levels, vk::Format format, vk::Extent3D extent, uint32_t layer_count, const VmaAllocator& va, bool host_visible = false, vk::ImageCreateFlags create_flags = {});
+	void create_volume_from_data(const std::function<void(uint32_t, uint32_t, unsigned char*)>& load_slices, VulkanCommandContext& vcc, Queues queues, vk::ImageUsageFlags usage_flags, vk::DeviceSize staging_byte_size);
+	void create_image_from_data(std::span<const std::span<const unsigned char>> layers, VulkanCommandContext& vcc, Queues queues, uint32_t base_mip_map_lvl, vk::ImageUsageFlags usage_flags, vk::ImageViewType image_view_type = vk::ImageViewType::e2D, PixelConversion conversion = PixelConversion::None);
+	bool is_host_image_copy_usable(vk::ImageUsageFlags usage, vk::ImageLayout layout) const;
 	void create_image_view(vk::ImageAspectFlags aspects, vk::ImageViewType image_view_type = vk::ImageViewType::e2D);
-	void generate_mipmaps(VulkanCommandContext& vcc);
+	void generate_mipmaps(vk::CommandBuffer& cb);
+	vk::DeviceSize get_readback_byte_size() const;
+	void record_readback(vk::CommandBuffer& cb, vk::Buffer buffer);
+};
+
+struct ImageRequirement
+{
+	Image* image;
+	vk::ImageLayout layout;
+	vk::PipelineStageFlags2 stage;
+	vk::AccessFlags2 access;
+	std::optional<ImageSubresourceRangeDesc> range = std::nullopt;
 };
+
+// record the required barriers of multiple images in one pipeline barrier
+void require(vk::CommandBuffer& cb, const std::vector<ImageRequirement>& requirements);
 } // namespace vkte
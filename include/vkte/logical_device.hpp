@@ -13,7 +13,8 @@ enum class QueueIndex
 	Graphics,
 	Compute,
 	Transfer,
-	Present
+	Present,
+	SparseBinding
 };
 
 class LogicalDevice
@@ -24,14 +25,28 @@ public:
 		bool dynamic_polygon_mode = false;
 		bool ray_query = false;
 		bool acceleration_structure = false;
+		// sparse residency for 2D images, requires a queue family with sparse binding support
+		bool sparse_residency = false;
+		// pipelines are linked from libraries that are shared between pipelines (VK_EXT_graphics_pipeline_library)
+		bool graphics_pipeline_library = false;
+		// graphics pipelines use shader objects with all state set at bind time (VK_EXT_shader_object)
+		bool shader_object = false;
 	};
 
 	LogicalDevice() = default;
 	void construct(const PhysicalDevice& p_device, const Features& features, const QueueFamilies& queue_families, std::unordered_map<QueueIndex, vk::Queue>& queues);
 	void destruct();
 	const vk::Device& get() const;
+	// host image copy (core in vulkan 1.4, VK_EXT_host_image_copy before) is enabled if the device supports it
+	bool is_host_image_copy_supported() const;
+	// layouts that images can be transitioned to and copied into on the host
+	bool is_host_image_copy_dst_layout(vk::ImageLayout layout) const;
 
 private:
 	vk::Device device;
+	bool host_image_copy = false;
+	std::vector<vk::ImageLayout> host_image_copy_dst_layouts;
+
+	bool detect_host_image_copy(const PhysicalDevice& p_device, std::vector<const char*>& extensions);
 };
 } // namespace vkte
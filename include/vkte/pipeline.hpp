@@ -3,7 +3,13 @@
 #include "vulkan/vulkan.hpp"
 #include "vkte/vulkan_main_context.hpp"
 #include "vkte/shader.hpp"
+#include "vkte/shader_compiler.hpp"
+#include "vkte/spirv_reflection.hpp"
+#include "vkte/worker_pool.hpp"
+#include <array>
+#include <future>
 #include <memory>
+#include <span>
 
 namespace vkte
 {
@@ -14,19 +20,37 @@ public:
 	{
 		std::vector<vk::Format> color_formats;
 		vk::Format depth_format = vk::Format::eUndefined;
-		const vk::DescriptorSetLayout* set_layout;
+		// nullptr derives the set layouts and push constant ranges from the SPIR-V of the stages, pcrs are ignored then
+		const vk::DescriptorSetLayout* set_layout = nullptr;
 		std::vector<Shader> shaders;
 		vk::PolygonMode polygon_mode = vk::PolygonMode::eFill;
+		vk::CullModeFlags cull_mode = vk::CullModeFlagBits::eBack;
+		vk::FrontFace front_face = vk::FrontFace::eCounterClockwise;
+		bool depth_bias = false;
+		float depth_bias_constant_factor = 0.0f;
+		float depth_bias_clamp = 0.0f;
+		float depth_bias_slope_factor = 0.0f;
+		vk::SampleCountFlagBits sample_count = vk::SampleCountFlagBits::e1;
+		// minimum fraction of the samples that are shaded individually, 0 disables sample shading
+		// not supported with shader objects, where the fragment shader decides whether it runs per sample
+		float min_sample_shading = 0.0f;
+		vk::CompareOp depth_compare_op = vk::CompareOp::eLess;
+		bool stencil_test = false;
+		vk::StencilOpState stencil_front;
+		vk::StencilOpState stencil_back;
 		vk::PrimitiveTopology primitive_topology = vk::PrimitiveTopology::eTriangleList;
 		std::vector<vk::VertexInputBindingDescription> binding_descriptions;
 		std::vector<vk::VertexInputAttributeDescription> attribute_description;
 		std::vector<vk::PushConstantRange> pcrs;
 		bool additive_blending = false;
+		// one state per color attachment, if empty the state of all attachments is derived from additive_blending
+		std::vector<vk::PipelineColorBlendAttachmentState> blend_states;
 	};
 
 	struct ComputeSettings
 	{
-		const vk::DescriptorSetLayout* set_layout;
+		// nullptr derives the set layouts and push constant range from the SPIR-V, push_constant_byte_size is ignored then
+		const vk::DescriptorSetLayout* set_layout = nullptr;
 		Shader shader;
 		uint32_t push_constant_byte_size = 0;
 	};
@@ -38,17 +62,48 @@ public:
 	};
 
 	Pipeline(const VulkanMainContext& vmc, Type type);
+	Type get_type() const;
 	GraphicsSettings& get_graphics_settings();
 	ComputeSettings& get_compute_settings();
 
-	bool compile_shaders();
+	// compiles the shaders with up to job_count compiler processes at the same time, 0 uses one job per hardware thread
+	bool compile_shaders(uint32_t job_count = 0);
+	// compile the shaders of all pipelines in one batch, returns false if a shader of any pipeline failed
+	static bool compile_shaders(const std::vector<Pipeline*>& pipelines, uint32_t job_count = 0);
 	void construct();
+	// construct the pipelines with one pipeline creation call per type, the shaders have to be compiled already
+	static void construct(const std::vector<Pipeline*>& pipelines);
+	// compile the shaders and construct the pipeline on a thread of the pool, the future tells whether it succeeded
+	// until then get() and get_layout() return the fallback (e.g. a simpler variant) if one is given, the fallback has to outlive the construction
+	// without a fallback they return VK_NULL_HANDLE until then, so callers have to check is_ready() before using the pipeline
+	// the pipeline must not be moved while it is constructed
+	std::shared_future<bool> construct_async(WorkerPool& pool, const Pipeline* fallback = nullptr);
+	// false while an asynchronous construction is running
+	bool is_ready() const;
+	// for pipelines that are linked from libraries, link the libraries again with link time optimization on a thread of the pool
+	// other pipelines are already optimized and the future is ready immediately
+	// get() returns the optimized pipeline once it is ready, the fast linked pipeline is kept until the pipeline is destroyed as it may still be in use
+	std::shared_future<bool> optimize_async(WorkerPool& pool);
+	bool is_optimized() const;
 	void reconstruct();
+	// exchange the settings and constructed state with another pipeline of the same type, e.g. to replace a pipeline with a rebuilt one
+	void swap(Pipeline& other);
 	void destruct();
+	// the pipeline handle, VK_NULL_HANDLE for graphics pipelines that use shader objects
 	const vk::Pipeline& get() const;
+	// binds the pipeline or its shader objects together with the dynamic state, works with both backends
+	// viewport and scissor are only used by graphics pipelines
+	void bind(const vk::CommandBuffer& cb, const vk::Viewport& viewport, const vk::Rect2D& scissor) const;
 	const vk::PipelineLayout& get_layout() const;
+	// one layout per set, all sets of the shaders if the layouts are reflected
+	const std::vector<vk::DescriptorSetLayout>& get_set_layouts() const;
+	// merged reflection of all stages, only available for compute pipelines and pipelines with reflected layouts
+	const ShaderReflection& get_reflection() const;
+	std::array<uint32_t, 3> get_local_size() const;
 
 private:
+	struct GraphicsState;
+
 	Type type;
 	std::unique_ptr<GraphicsSettings> graphics_settings;
 	std::unique_ptr<ComputeSettings> compute_settings;
@@ -58,5 +113,38 @@ private:
 	vk::Pipeline pipeline;
 	std::vector<vk::PipelineShaderStageCreateInfo> shader_stages;
 	std::vector<vk::SpecializationInfo> spec_infos;
+	std::vector<uint64_t> spirv_hashes;
+	// only kept for shader objects, which are created from the code instead of shader modules
+	std::vector<std::string> spirv_codes;
+	std::vector<vk::ShaderEXT> shader_objects;
+	std::shared_future<bool> construction;
+	const Pipeline* fallback = nullptr;
+	// vertex input, pre-rasterization, fragment shader and fragment output library, if graphics pipeline libraries are enabled
+	std::array<vk::Pipeline, 4> libraries{};
+	vk::Pipeline optimized_pipeline;
+	std::shared_future<bool> optimization;
+	ShaderReflection reflection;
+	std::vector<vk::DescriptorSetLayout> set_layouts;
+	std::vector<vk::PushConstantRange> push_constant_ranges;
+	// reflected layouts are acquired from the layout cache
+	bool reflected_layout = false;
+
+	bool is_fallback_used() const;
+	bool use_shader_objects() const;
+	bool use_pipeline_libraries() const;
+	void create_shader_objects();
+	uint64_t hash_shader_stages(bool fragment, uint64_t hash) const;
+	std::array<uint64_t, 4> get_library_keys() const;
+	void create_libraries(const vk::GraphicsPipelineCreateInfo& gpci);
+	vk::Pipeline link_libraries(bool optimize) const;
+	void destroy_pipeline();
+	void create_layout();
+	std::vector<vk::PipelineColorBlendAttachmentState> get_blend_states() const;
+	void fill_graphics_state(GraphicsState& state) const;
+	vk::ComputePipelineCreateInfo get_compute_create_info() const;
+	bool needs_reflection() const;
+	void create_pipeline_layout(const vk::DescriptorSetLayout* set_layout, const std::vector<vk::PushConstantRange>& pcrs);
+	std::span<const Shader> get_shaders() const;
+	bool create_shader_stages(std::span<const ShaderCompileResult> results);
 };
 } // namespace vkte
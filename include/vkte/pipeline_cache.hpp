@@ -0,0 +1,38 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include "vulkan/vulkan.hpp"
+
+namespace vkte
+{
+// device wide pipeline cache that is stored on disk, so that the driver does not have to compile all pipelines again on the next start
+// the cache is saved periodically by a background thread if it grew and once more when it is destroyed
+class PipelineCache
+{
+public:
+	static constexpr std::chrono::seconds save_interval{30};
+
+	PipelineCache() = default;
+	void construct(const vk::Device& device, const vk::PhysicalDevice& physical_device, const std::string& file_path);
+	void destruct();
+	void save();
+	vk::PipelineCache get() const;
+
+private:
+	vk::Device device;
+	vk::PipelineCache cache;
+	std::string file_path;
+	std::size_t saved_byte_size = 0;
+	std::mutex save_mutex;
+	std::mutex stop_mutex;
+	std::condition_variable stop_cv;
+	bool stop = false;
+	std::thread save_thread;
+
+	std::vector<char> load(const vk::PhysicalDevice& physical_device) const;
+};
+} // namespace vkte
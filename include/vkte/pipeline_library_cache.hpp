@@ -0,0 +1,36 @@
+#pragma once
+
+#include <array>
+#include <functional>
+#include <mutex>
+#include <unordered_map>
+#include "vulkan/vulkan.hpp"
+
+namespace vkte
+{
+// shares the libraries of graphics pipelines (VK_EXT_graphics_pipeline_library), pipelines with the same state of a part only compile it once
+// the libraries are kept until the cache is destroyed
+class PipelineLibraryCache
+{
+public:
+	enum class Part
+	{
+		VertexInput,
+		PreRasterization,
+		FragmentShader,
+		FragmentOutput
+	};
+
+	PipelineLibraryCache() = default;
+	void construct(const vk::Device& device);
+	void destruct();
+	// returns the library of the part with the given key or creates it, create may be called by multiple threads for the same key at once
+	vk::Pipeline get(Part part, uint64_t key, const std::function<vk::Pipeline()>& create);
+	uint32_t get_library_count() const;
+
+private:
+	vk::Device device;
+	mutable std::mutex mutex;
+	std::array<std::unordered_map<uint64_t, vk::Pipeline>, 4> libraries;
+};
+} // namespace vkte
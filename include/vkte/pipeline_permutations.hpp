@@ -0,0 +1,51 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "vkte/pipeline.hpp"
+
+namespace vkte
+{
+// variants of one pipeline template that differ in their specialization constants
+// every axis is a uint32_t specialization constant of all shaders of the template, the values of a variant are packed into a bit key
+class PipelinePermutations
+{
+public:
+	PipelinePermutations(const VulkanMainContext& vmc, Pipeline::Type type);
+	// the template that all variants are created from, specialization constants of the axes are added per variant
+	Pipeline::GraphicsSettings& get_graphics_settings();
+	Pipeline::ComputeSettings& get_compute_settings();
+	// the axis takes values in [0, value_count), returns the index of the axis
+	uint32_t add_axis(const std::string& name, uint32_t constant_id, uint32_t value_count);
+	// values are given in the order of the axes
+	uint64_t get_key(const std::vector<uint32_t>& values) const;
+	// compile and create all variants in one batch, variants that already exist are skipped
+	bool construct(const std::vector<std::vector<uint32_t>>& variants);
+	// one variant per line as axis=value pairs separated by whitespace, axes that are not given are 0 and # starts a comment
+	bool construct_from_manifest(const std::string& path);
+	void destruct();
+	bool contains(uint64_t key) const;
+	const Pipeline& get(uint64_t key) const;
+	uint32_t get_variant_count() const;
+
+private:
+	struct Axis
+	{
+		std::string name;
+		uint32_t constant_id;
+		uint32_t value_count;
+		uint32_t bit_offset;
+		uint32_t bit_count;
+	};
+
+	const VulkanMainContext& vmc;
+	Pipeline::Type type;
+	Pipeline::GraphicsSettings graphics_settings;
+	Pipeline::ComputeSettings compute_settings;
+	std::vector<Axis> axes;
+	uint32_t bit_count = 0;
+	std::unordered_map<uint64_t, std::unique_ptr<Pipeline>> pipelines;
+};
+} // namespace vkte
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include "vkte/format_info.hpp"
+
+namespace vkte
+{
+// conversions that are applied to the source data while it is written to the staging buffer
+enum class PixelConversion
+{
+	None,
+	// 3 byte RGB to 4 byte RGBA with opaque alpha
+	RGB8ToRGBA8,
+	// swap the red and blue channel of 4 byte pixels, also converts RGBA8 to BGRA8
+	BGRA8ToRGBA8,
+	PremultiplyAlphaRGBA8,
+	PremultiplyAlphaRGBA32F,
+	// 32 bit floats to 16 bit floats, works for any number of components
+	F32ToF16,
+	// sRGB encoded 8 bit RGBA to linear float RGBA, alpha is always linear
+	SRGBA8ToLinearRGBA32F,
+	LinearRGBA32FToSRGBA8
+};
+
+// check if the conversion produces texels of the given format
+bool is_conversion_valid(PixelConversion conversion, const FormatInfo& format_info);
+uint32_t get_source_texel_byte_size(PixelConversion conversion, const FormatInfo& format_info);
+// convert texel_count texels of source data to the layout of the given format
+void convert_pixels(PixelConversion conversion, const unsigned char* src, unsigned char* dst, std::size_t texel_count, const FormatInfo& format_info);
+
+// the kernels select the fastest implementation supported by the cpu at runtime
+// source and destination may be the same for conversions that do not change the texel size
+void rgb8_to_rgba8(const uint8_t* src, uint8_t* dst, std::size_t pixel_count);
+// dst[i] = src[order[i]] for every channel i of every pixel
+void swizzle_rgba8(const uint8_t* src, uint8_t* dst, std::size_t pixel_count, std::array<uint8_t, 4> order);
+void premultiply_alpha_rgba8(const uint8_t* src, uint8_t* dst, std::size_t pixel_count);
+void premultiply_alpha_rgba32f(const float* src, float* dst, std::size_t pixel_count);
+void f32_to_f16(const float* src, uint16_t* dst, std::size_t count);
+void srgb8_to_linear_rgba32f(const uint8_t* src, float* dst, std::size_t pixel_count);
+void linear_rgba32f_to_srgb8(const float* src, uint8_t* dst, std::size_t pixel_count);
+// single component versions of the sRGB conversions with the same tables as the kernels
+float srgb8_to_linear(uint8_t c);
+uint8_t linear_to_srgb8(float l);
+
+float half_to_float(uint16_t h);
+uint16_t float_to_half(float f);
+} // namespace vkte
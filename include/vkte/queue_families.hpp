@@ -11,7 +11,8 @@ enum class QueueFamilyFlags : uint32_t
 	Graphics = (1 << 0),
 	Compute = (1 << 1),
 	Transfer = (1 << 2),
-	Present = (1 << 3)
+	Present = (1 << 3),
+	SparseBinding = (1 << 4)
 };
 
 using Queues = NamedBitfield<QueueFamilyFlags>;
@@ -36,11 +37,14 @@ private:
 		int32_t compute = -1;
 		int32_t transfer = -1;
 		int32_t present = -1;
+		// optional, stays -1 if no queue family supports sparse binding
+		int32_t sparse_binding = -1;
 	} indices;
 
 	Queues graphics = QueueFamilyFlags::Graphics;
 	Queues compute = QueueFamilyFlags::Compute;
 	Queues transfer = QueueFamilyFlags::Transfer;
 	Queues present = QueueFamilyFlags::Present;
+	Queues sparse_binding = QueueFamilyFlags::SparseBinding;
 };
 } // namespace vkte
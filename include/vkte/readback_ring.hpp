@@ -0,0 +1,73 @@
+#pragma once
+
+#include <span>
+#include <utility>
+#include <vector>
+#include "vulkan/vulkan.hpp"
+#include "vkte/vulkan_main_context.hpp"
+#include "vk_mem_alloc.h"
+
+namespace vkte
+{
+class ReadbackRing;
+
+// handle of a readback that was recorded into a command buffer, the data is available once the submission signaled its fence or timeline value
+class ReadbackHandle
+{
+public:
+	ReadbackHandle() = default;
+	bool is_ready() const;
+	// wait for the copy and return the data, the data stays valid until the ring reuses the slot
+	std::span<const unsigned char> get() const;
+	vk::DeviceSize get_byte_size() const;
+
+private:
+	friend class ReadbackRing;
+	ReadbackHandle(ReadbackRing* ring, uint32_t slot, uint64_t generation, vk::DeviceSize byte_size);
+
+	ReadbackRing* ring = nullptr;
+	uint32_t slot = 0;
+	uint64_t generation = 0;
+	vk::DeviceSize byte_size = 0;
+};
+
+// fixed set of persistently mapped host cached buffers that readbacks cycle through
+// a slot is only reused after its previous readback finished, so the slot count bounds the number of readbacks in flight
+class ReadbackRing
+{
+public:
+	ReadbackRing(const VulkanMainContext& vmc);
+	void construct(uint32_t slot_count, vk::DeviceSize slot_byte_size);
+	void destruct();
+	// reserve the next slot for a copy that is finished when the fence or the timeline semaphore value is signaled
+	// a fence must not be reset before the data of the readback was obtained
+	std::pair<vk::Buffer, ReadbackHandle> acquire(vk::DeviceSize byte_size, vk::Fence fence);
+	std::pair<vk::Buffer, ReadbackHandle> acquire(vk::DeviceSize byte_size, vk::Semaphore timeline, uint64_t timeline_value);
+	vk::DeviceSize get_slot_byte_size() const;
+
+private:
+	friend class ReadbackHandle;
+
+	struct Slot
+	{
+		vk::Buffer buffer;
+		VmaAllocation vmaa;
+		void* mapped_mem;
+		uint64_t generation = 0;
+		bool pending = false;
+		vk::Fence fence;
+		vk::Semaphore timeline;
+		uint64_t timeline_value = 0;
+	};
+
+	const VulkanMainContext& vmc;
+	std::vector<Slot> slots;
+	vk::DeviceSize slot_byte_size = 0;
+	uint32_t next_slot = 0;
+
+	Slot& acquire_slot(vk::DeviceSize byte_size);
+	bool is_finished(const Slot& slot) const;
+	void wait(Slot& slot) const;
+	std::span<const unsigned char> read(uint32_t slot_idx, uint64_t generation, vk::DeviceSize byte_size);
+};
+} // namespace vkte
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <mutex>
+#include <unordered_map>
+#include "vulkan/vulkan.hpp"
+#include "vulkan/vulkan_hash.hpp"
+
+namespace vkte
+{
+// shares samplers with identical state, samplers are reference counted and destroyed with the last release
+class SamplerCache
+{
+public:
+	SamplerCache() = default;
+	void construct(const vk::Device& device);
+	void destruct();
+	vk::Sampler acquire(const vk::SamplerCreateInfo& sci);
+	void release(vk::Sampler sampler);
+	uint32_t get_sampler_count() const;
+
+private:
+	struct Entry
+	{
+		vk::Sampler sampler;
+		uint32_t ref_count;
+	};
+
+	vk::Device device;
+	mutable std::mutex mutex;
+	std::unordered_map<vk::SamplerCreateInfo, Entry> samplers;
+	std::unordered_map<vk::Sampler, vk::SamplerCreateInfo> sampler_infos;
+};
+} // namespace vkte
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include "vkte/shader.hpp"
+
+namespace vkte
+{
+struct ShaderCompileResult
+{
+	bool success = false;
+	// the SPIR-V was up to date and the compiler was not run
+	bool cached = false;
+	std::string spirv_path;
+	// output of the compiler
+	std::string diagnostics;
+};
+
+// compile a shader of shader_root_dir to shader_root_dir/bin/<name>.spv
+// the compiler only runs if the hash of the source, all files it includes or imports, the compiler version and the arguments changed
+// the hash the SPIR-V was compiled from is stored next to it in <name>.spv.hash
+ShaderCompileResult compile_shader(const std::string& shader_root_dir, const Shader& shader);
+// compile many shaders with up to job_count compiler processes at the same time, 0 uses one job per hardware thread
+// the results are in the order of the shaders, shaders that are contained multiple times are only compiled once
+std::vector<ShaderCompileResult> compile_shaders(const std::string& shader_root_dir, const std::vector<Shader>& shaders, uint32_t job_count = 0);
+// source file of the shader and all files it includes or imports
+std::vector<std::string> get_shader_files(const std::string& shader_root_dir, const Shader& shader);
+// 64 bit FNV-1a, used to detect changes of shader inputs and to identify pipeline state
+constexpr uint64_t hash_offset_basis = 0xcbf29ce484222325ull;
+uint64_t hash_bytes(const void* data, std::size_t byte_count, uint64_t hash = hash_offset_basis);
+// run a command and collect its standard and error output, returns the exit code
+int run_command(const std::string& command, std::string& output);
+} // namespace vkte
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <filesystem>
+#include <map>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include "vulkan/vulkan.hpp"
+#include "vulkan/vulkan_hash.hpp"
+
+namespace vkte
+{
+// shares shader modules between pipelines, modules are keyed by the path and the content hash of the SPIR-V
+// modules are reference counted and destroyed with the last release, specialization info stays with each pipeline
+class ShaderModuleCache
+{
+public:
+	ShaderModuleCache() = default;
+	void construct(const vk::Device& device);
+	void destruct();
+	// the file is only read if it changed since it was last acquired, spirv_hash is set to the hash of its content
+	vk::ShaderModule acquire(const std::string& spirv_path, uint64_t& spirv_hash);
+	void release(vk::ShaderModule module);
+	uint32_t get_module_count() const;
+
+private:
+	using Key = std::pair<std::string, uint64_t>;
+	struct Entry
+	{
+		vk::ShaderModule module;
+		uint32_t ref_count;
+	};
+	struct FileState
+	{
+		std::filesystem::file_time_type write_time;
+		std::uintmax_t byte_size;
+		uint64_t hash;
+	};
+
+	vk::Device device;
+	mutable std::mutex mutex;
+	std::map<Key, Entry> modules;
+	std::unordered_map<vk::ShaderModule, Key> module_keys;
+	std::unordered_map<std::string, FileState> file_states;
+};
+} // namespace vkte
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "vkte/pipeline.hpp"
+
+namespace vkte
+{
+// rebuilds registered pipelines on a background thread when a source file of one of their shaders changes (only on linux, uses inotify)
+// only shaders whose source or included files changed are recompiled, the other stages use their up to date SPIR-V
+class ShaderWatcher
+{
+public:
+	ShaderWatcher(const VulkanMainContext& vmc);
+	// replaced pipelines are destroyed once no frame in flight can use them anymore
+	void construct(uint32_t frames_in_flight);
+	void destruct();
+	// the pipeline has to be constructed and must not be moved until it is removed
+	void add_pipeline(Pipeline& pipeline);
+	void remove_pipeline(Pipeline& pipeline);
+	// has to be called once per frame while no command buffer that uses a registered pipeline is recorded
+	// swaps the rebuilt pipelines in and returns them, pipelines that failed to rebuild keep their old state
+	std::vector<Pipeline*> update();
+
+private:
+	const VulkanMainContext& vmc;
+	uint32_t frames_in_flight = 0;
+	uint64_t frame = 0;
+	int inotify_fd = -1;
+	std::thread thread;
+	std::atomic<bool> stop = false;
+	std::mutex mutex;
+	// source files of the shaders of each registered pipeline
+	std::unordered_map<Pipeline*, std::unordered_set<std::string>> pipelines;
+	// directory of each watch descriptor
+	std::unordered_map<int, std::string> watched_dirs;
+
+	struct RebuiltPipeline
+	{
+		Pipeline* pipeline;
+		std::unique_ptr<Pipeline> rebuilt;
+	};
+	std::vector<RebuiltPipeline> rebuilt_pipelines;
+
+	// the old state of a swapped pipeline
+	struct RetiredPipeline
+	{
+		std::unique_ptr<Pipeline> pipeline;
+		uint64_t frame;
+	};
+	std::vector<RetiredPipeline> retired_pipelines;
+
+	std::unordered_set<std::string> get_files(Pipeline& pipeline) const;
+	void watch(const std::unordered_set<std::string>& files);
+	void run();
+	std::unordered_set<std::string> read_changed_files();
+	void rebuild(Pipeline* pipeline);
+	void destroy_retired_pipelines(bool all);
+};
+} // namespace vkte
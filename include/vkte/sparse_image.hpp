@@ -0,0 +1,59 @@
+#pragma once
+
+#include <vector>
+#include "vkte/image.hpp"
+#include "vk_mem_alloc.h"
+
+namespace vkte
+{
+// 2D image with sparse residency, tiles are made resident or non-resident at runtime
+// the residency changes are collected and submitted together with submit_binds()
+class SparseImage
+{
+public:
+	SparseImage(const VulkanMainContext& vmc, const VulkanCommandContext& vcc, uint32_t width, uint32_t height, vk::Format format, vk::ImageUsageFlags usage, bool use_mip_maps, Queues queues);
+	void destruct();
+	// tiles are addressed in units of the tile extent of the given mip level, the levels of the mip tail are always resident
+	void make_resident(uint32_t mip_level, uint32_t tile_x, uint32_t tile_y);
+	void make_non_resident(uint32_t mip_level, uint32_t tile_x, uint32_t tile_y);
+	bool is_resident(uint32_t mip_level, uint32_t tile_x, uint32_t tile_y) const;
+	// submit all queued residency changes in one vkQueueBindSparse call on the sparse binding queue
+	// work that accesses the changed tiles has to wait for one of the signal semaphores
+	void submit_binds(const std::vector<vk::Semaphore>& wait_semaphores, const std::vector<vk::Semaphore>& signal_semaphores);
+	bool has_pending_binds() const;
+	vk::Extent3D get_tile_extent() const;
+	uint32_t get_tile_count_x(uint32_t mip_level) const;
+	uint32_t get_tile_count_y(uint32_t mip_level) const;
+	// first mip level that is part of the always resident mip tail
+	uint32_t get_mip_tail_first_level() const;
+	uint32_t get_resident_tile_count() const;
+	Image& get_image();
+
+private:
+	const VulkanMainContext& vmc;
+	Image image;
+	uint32_t mip_levels;
+	vk::Extent3D tile_extent;
+	vk::DeviceSize tile_byte_size;
+	uint32_t mip_tail_first_level;
+	VmaPool pool;
+	// one entry per tile of every mip level that is not part of the mip tail, VK_NULL_HANDLE for non-resident tiles
+	std::vector<std::vector<VmaAllocation>> page_table;
+	std::vector<VmaAllocation> mip_tail_allocations;
+	uint32_t resident_tile_count = 0;
+	std::vector<vk::SparseImageMemoryBind> pending_binds;
+	std::vector<vk::SparseMemoryBind> pending_opaque_binds;
+	// pages that were unbound are freed after the binding operation finished
+	std::vector<VmaAllocation> pending_frees;
+	struct InFlightBinds
+	{
+		vk::Fence fence;
+		std::vector<VmaAllocation> frees;
+	};
+	std::vector<InFlightBinds> in_flight_binds;
+
+	void bind_mip_tail(const vk::SparseImageMemoryRequirements& requirements, const vk::MemoryRequirements& memory_requirements);
+	void add_pending_bind(const vk::SparseImageMemoryBind& bind);
+	void free_finished_pages(bool wait);
+};
+} // namespace vkte
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <array>
+#include <string>
+#include <vector>
+#include "vulkan/vulkan.hpp"
+
+namespace vkte
+{
+// descriptor count used for runtime arrays (e.g. sampler2D textures[]), as their size is not part of the SPIR-V
+constexpr uint32_t runtime_array_descriptor_count = 1024;
+
+// resource interface of one or more shader stages
+struct ShaderReflection
+{
+	struct Binding
+	{
+		uint32_t set;
+		uint32_t binding;
+		vk::DescriptorType type;
+		// 0 for runtime arrays
+		uint32_t descriptor_count;
+		vk::ShaderStageFlags stages;
+	};
+	// sorted by set and binding
+	std::vector<Binding> bindings;
+	// one range per stage, from the first to the last byte of the push constant block that the stage declares
+	std::vector<vk::PushConstantRange> push_constant_ranges;
+	// only set for compute shaders
+	std::array<uint32_t, 3> local_size = {1, 1, 1};
+
+	uint32_t get_set_count() const;
+	// bindings of one set in the form of DescriptorSetHandler::add_binding
+	std::vector<vk::DescriptorSetLayoutBinding> get_layout_bindings(uint32_t set) const;
+};
+
+// self-contained parser for the decorations and types that are needed to derive layouts, anything else in the module is skipped
+// for SPIR-V 1.4 and later only the resources of the entry point interface are reflected, before that all declared resources
+ShaderReflection reflect_spirv(const uint32_t* code, std::size_t word_count, vk::ShaderStageFlagBits stage);
+ShaderReflection reflect_spirv_file(const std::string& spirv_path, vk::ShaderStageFlagBits stage);
+// combine the reflections of the stages of a pipeline, resources that are used by multiple stages get all of their stage flags
+ShaderReflection merge_reflections(const std::vector<ShaderReflection>& reflections);
+} // namespace vkte
@@ -17,6 +17,7 @@ public:
 	vk::Extent2D get_extent() const;
 	vk::ImageView get_view(uint32_t idx) const;
 	vk::Image get_image(uint32_t idx) const;
+	// the depth buffer is a transient attachment, it has to be cleared at the start of rendering and must not be stored
 	vk::ImageView get_depth_view() const;
 	vk::Image get_depth_image() const;
 	vk::Format get_color_format() const;
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include "vkte/buffer.hpp"
+#include "vkte/image.hpp"
+#include "vkte/storage.hpp"
+
+namespace vkte
+{
+// streams the mip levels of textures based on the finest level that is actually sampled
+// a texture is kept as one image in the storage that contains all levels from its resident level on, changing the resident level replaces the image
+class TextureStreamer
+{
+public:
+	// shaders report the sampled level biased by this value, as levels finer than the resident level are negative:
+	// atomicMin(feedback[texture_id], uint(max(textureQueryLod(tex, uv).y + feedback_lod_bias, 0.0)));
+	static constexpr uint32_t feedback_lod_bias = 16;
+
+	TextureStreamer(const VulkanMainContext& vmc, VulkanCommandContext& vcc, Storage& storage);
+	// upload_budget limits the bytes uploaded per update, memory_budget limits the bytes of all resident textures
+	void construct(uint32_t frames_in_flight, uint32_t max_texture_count, vk::DeviceSize upload_budget, vk::DeviceSize memory_budget);
+	void destruct();
+	// the source data is kept in host memory so that finer levels can be uploaded at any time
+	// the texture starts with the finest level that is not larger than min_resident_extent
+	uint32_t add_texture(const std::string& name, std::vector<unsigned char> data, vk::Format format, uint32_t width, uint32_t height, vk::ImageUsageFlags usage_flags = vk::ImageUsageFlagBits::eSampled, Queues queues = QueueFamilyFlags::Graphics, uint32_t min_resident_extent = 64);
+	// cpu side estimate of the required level, e.g. from the projected size of the object on the screen
+	void request_screen_size(uint32_t texture_id, float screen_width, float screen_height);
+	void request_mip_level(uint32_t texture_id, uint32_t mip_level);
+	// storage buffer with one uint per texture, the shaders write the sampled level into it (see feedback_lod_bias)
+	const Buffer& get_feedback_buffer(uint32_t frame_index) const;
+	// has to be called once per frame after the frame with the given index finished on the gpu
+	// returns the ids of textures whose image was replaced, descriptors that use these images have to be updated
+	std::vector<uint32_t> update(uint32_t frame_index);
+	Image& get_image(uint32_t texture_id);
+	uint32_t get_resident_mip_level(uint32_t texture_id) const;
+	uint32_t get_mip_level_count(uint32_t texture_id) const;
+	vk::DeviceSize get_resident_byte_size() const;
+
+private:
+	const VulkanMainContext& vmc;
+	VulkanCommandContext& vcc;
+	Storage& storage;
+	uint32_t frames_in_flight = 0;
+	uint32_t max_texture_count = 0;
+	vk::DeviceSize upload_budget = 0;
+	vk::DeviceSize memory_budget = 0;
+	vk::DeviceSize resident_byte_size = 0;
+	uint64_t frame = 0;
+	std::vector<Buffer> feedback_buffers;
+
+	struct Texture
+	{
+		std::string name;
+		std::vector<unsigned char> data;
+		vk::Format format;
+		uint32_t width;
+		uint32_t height;
+		vk::ImageUsageFlags usage_flags;
+		Queues queues;
+		uint32_t mip_level_count;
+		uint32_t coarsest_level;
+		uint32_t resident_level;
+		uint32_t storage_idx;
+		// finest level requested by the cpu or reported by the feedback since the last update
+		uint32_t requested_level;
+		// level that is wanted, it only gets coarser if the texture was not requested for some frames
+		uint32_t wanted_level;
+		uint64_t last_requested_frame = 0;
+	};
+	std::vector<Texture> textures;
+
+	// replaced images are destroyed once no frame in flight can use them anymore
+	struct RetiredImage
+	{
+		std::string name;
+		uint32_t storage_idx;
+		vk::DeviceSize byte_size;
+		uint64_t frame;
+	};
+	std::vector<RetiredImage> retired_images;
+
+	vk::DeviceSize get_byte_size(const Texture& texture, uint32_t level) const;
+	std::string get_image_name(const Texture& texture, uint32_t level) const;
+	void read_feedback(uint32_t frame_index);
+	void make_resident(Texture& texture, uint32_t level);
+	void destroy_retired_images(bool all);
+	bool is_memory_pressure() const;
+};
+} // namespace vkte
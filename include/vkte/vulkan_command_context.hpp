@@ -1,5 +1,6 @@
 #pragma once
 
+#include <functional>
 #include "vulkan/vulkan.hpp"
 #include "vkte/command_pool.hpp"
 #include "vkte/vulkan_main_context.hpp"
@@ -22,6 +23,13 @@ public:
 	void submit_graphics(const vk::CommandBuffer& cb, bool wait_idle) const;
 	void submit_compute(const vk::CommandBuffer& cb, bool wait_idle) const;
 	void submit_transfer(const vk::CommandBuffer& cb, bool wait_idle) const;
+	// while an upload batch is open, resource uploads are recorded into one graphics command buffer and submitted together
+	void begin_upload_batch();
+	void submit_upload_batch();
+	bool is_upload_batch_open() const;
+	vk::CommandBuffer& get_upload_buffer();
+	// resources that are used by the recorded uploads (e.g. staging buffers) are destroyed in the given function after submission
+	void defer_until_upload_submitted(std::function<void()> cleanup);
 
 	const VulkanMainContext& vmc;
 	std::vector<CommandPool> command_pools;
@@ -39,6 +47,10 @@ private:
 		TYPE_COUNT
 	};
 
+	vk::CommandBuffer upload_cb;
+	bool upload_batch_open = false;
+	std::vector<std::function<void()>> upload_cleanups;
+
 	void submit(const vk::CommandBuffer& cb, const vk::Queue& queue, bool wait_idle) const;
 };
 } // namespace vkte
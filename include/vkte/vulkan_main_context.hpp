@@ -2,8 +2,13 @@
 
 #include "vulkan/vulkan.hpp"
 #include "vkte/queue_families.hpp"
+#include "vkte/descriptor_set_layout_cache.hpp"
 #include "vkte/logical_device.hpp"
 #include "vkte/physical_device.hpp"
+#include "vkte/pipeline_cache.hpp"
+#include "vkte/pipeline_library_cache.hpp"
+#include "vkte/sampler_cache.hpp"
+#include "vkte/shader_module_cache.hpp"
 #if ENABLE_VKTE_WINDOW
 #include "vkte_window/window.hpp"
 #endif
@@ -37,6 +42,8 @@ public:
 	const vk::Queue& get_transfer_queue() const;
 	const vk::Queue& get_compute_queue() const;
 	const vk::Queue& get_present_queue() const;
+	// only available if sparse residency is enabled
+	const vk::Queue& get_sparse_binding_queue() const;
 	const Features& get_features() const;
 	std::string shader_root_dir;
 
@@ -59,5 +66,13 @@ public:
 	QueueFamilies queue_families;
 	LogicalDevice logical_device;
 	VmaAllocator va;
+	// device wide caches are mutable, as the main context is only passed as const reference
+	mutable SamplerCache sampler_cache;
+	// stored in the bin directory of the shader root directory
+	mutable PipelineCache pipeline_cache;
+	// only used if graphics pipeline libraries are enabled
+	mutable PipelineLibraryCache pipeline_library_cache;
+	mutable ShaderModuleCache shader_module_cache;
+	mutable DescriptorSetLayoutCache descriptor_set_layout_cache;
 };
 } // namespace vkte
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+namespace vkte
+{
+// fixed number of threads that execute submitted jobs in submission order
+class WorkerPool
+{
+public:
+	WorkerPool() = default;
+	// 0 uses one thread per hardware thread
+	void construct(uint32_t thread_count = 0);
+	// finishes all submitted jobs before the threads are joined
+	void destruct();
+	uint32_t get_thread_count() const;
+
+	template<typename F>
+	std::future<std::invoke_result_t<F>> submit(F&& job)
+	{
+		auto task = std::make_shared<std::packaged_task<std::invoke_result_t<F>()>>(std::forward<F>(job));
+		std::future<std::invoke_result_t<F>> future = task->get_future();
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			jobs.emplace([task]() { (*task)(); });
+		}
+		cv.notify_one();
+		return future;
+	}
+
+private:
+	std::vector<std::thread> threads;
+	std::queue<std::function<void()>> jobs;
+	std::mutex mutex;
+	std::condition_variable cv;
+	bool stop = false;
+};
+} // namespace vkte
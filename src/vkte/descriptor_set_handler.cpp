@@ -21,6 +21,11 @@ void DescriptorSetHandler::add_binding(uint32_t binding, vk::DescriptorType type
 	descriptors.push_back(Descriptor(binding, type, stages, descriptor_count, set_count));
 }
 
+void DescriptorSetHandler::add_bindings(const ShaderReflection& reflection, uint32_t set)
+{
+	for (const vk::DescriptorSetLayoutBinding& dslb : reflection.get_layout_bindings(set)) add_binding(dslb.binding, dslb.descriptorType, dslb.stageFlags, dslb.descriptorCount);
+}
+
 void DescriptorSetHandler::add_descriptor(uint32_t set, uint32_t binding, const std::vector<Buffer>& buffers)
 {
 	for (auto d = descriptors.begin(); d != descriptors.end(); ++d)
@@ -68,19 +73,8 @@ void DescriptorSetHandler::construct()
 {
 	std::vector<vk::DescriptorSetLayoutBinding> layout_bindings;
 	for (const auto& d : descriptors) layout_bindings.push_back(d.dslb);
-	for (uint32_t i = 0; i < set_count; ++i)
-	{
-		std::vector<vk::DescriptorBindingFlags> binding_flags(layout_bindings.size(), vk::DescriptorBindingFlagBits::ePartiallyBound);
-		vk::DescriptorSetLayoutBindingFlagsCreateInfo dslbfci;
-		dslbfci.bindingCount = layout_bindings.size();
-		dslbfci.pBindingFlags = binding_flags.data();
-
-		vk::DescriptorSetLayoutCreateInfo dslci;
-		dslci.bindingCount = layout_bindings.size();
-		dslci.pBindings = layout_bindings.data();
-		dslci.pNext = &dslbfci;
-		layouts.push_back(vmc.logical_device.get().createDescriptorSetLayout(dslci));
-	}
+	// pipelines with the same bindings share the layout
+	layouts.assign(set_count, vmc.descriptor_set_layout_cache.acquire(layout_bindings));
 
 	std::vector<vk::DescriptorPoolSize> pool_sizes;
 	for (const auto& d : descriptors)
@@ -131,7 +125,7 @@ void DescriptorSetHandler::construct()
 
 void DescriptorSetHandler::destruct()
 {
-	for (auto& dsl : layouts) vmc.logical_device.get().destroyDescriptorSetLayout(dsl);
+	if (!layouts.empty()) vmc.descriptor_set_layout_cache.release(layouts[0]);
 	layouts.clear();
 	vmc.logical_device.get().destroyDescriptorPool(pool);
 	descriptors.clear();
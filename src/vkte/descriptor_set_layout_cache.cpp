@@ -0,0 +1,85 @@
+#include "vkte/descriptor_set_layout_cache.hpp"
+
+#include "vkte/shader_compiler.hpp"
+#include "vkte/vkte_log.hpp"
+
+namespace vkte
+{
+void DescriptorSetLayoutCache::construct(const vk::Device& device)
+{
+	this->device = device;
+}
+
+void DescriptorSetLayoutCache::destruct()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	if (!layouts.empty()) VKTE_WARN("vkte: {} descriptor set layout(s) not released! Cleaning up...", layouts.size());
+	for (const std::pair<const Key, Entry>& layout : layouts) device.destroyDescriptorSetLayout(layout.second.layout);
+	layouts.clear();
+	layout_keys.clear();
+}
+
+vk::DescriptorSetLayout DescriptorSetLayoutCache::acquire(const std::vector<vk::DescriptorSetLayoutBinding>& bindings)
+{
+	// the key covers the bindings in their order, immutable samplers would be ignored
+	Key key;
+	for (const vk::DescriptorSetLayoutBinding& binding : bindings)
+	{
+		VKTE_ASSERT(binding.pImmutableSamplers == nullptr, "vkte: Cached descriptor set layouts do not support immutable samplers!");
+		key.push_back({binding.binding, uint32_t(binding.descriptorType), binding.descriptorCount, uint32_t(binding.stageFlags)});
+	}
+	std::lock_guard<std::mutex> lock(mutex);
+	auto it = layouts.find(key);
+	if (it != layouts.end())
+	{
+		it->second.ref_count++;
+		return it->second.layout;
+	}
+
+	std::vector<vk::DescriptorBindingFlags> binding_flags(bindings.size(), vk::DescriptorBindingFlagBits::ePartiallyBound);
+	vk::DescriptorSetLayoutBindingFlagsCreateInfo dslbfci;
+	dslbfci.bindingCount = binding_flags.size();
+	dslbfci.pBindingFlags = binding_flags.data();
+
+	vk::DescriptorSetLayoutCreateInfo dslci;
+	dslci.bindingCount = bindings.size();
+	dslci.pBindings = bindings.data();
+	dslci.pNext = &dslbfci;
+	vk::DescriptorSetLayout layout = device.createDescriptorSetLayout(dslci);
+	layout_keys.emplace(layout, key);
+	layouts.emplace(std::move(key), Entry{layout, 1});
+	return layout;
+}
+
+void DescriptorSetLayoutCache::release(vk::DescriptorSetLayout layout)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	auto key = layout_keys.find(layout);
+	if (key == layout_keys.end())
+	{
+		VKTE_ERROR("vkte: Trying to release descriptor set layout that is not in the cache!");
+		return;
+	}
+	auto it = layouts.find(key->second);
+	if (--it->second.ref_count == 0)
+	{
+		device.destroyDescriptorSetLayout(layout);
+		layouts.erase(it);
+		layout_keys.erase(key);
+	}
+}
+
+std::optional<uint64_t> DescriptorSetLayoutCache::get_binding_hash(vk::DescriptorSetLayout layout) const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	auto key = layout_keys.find(layout);
+	if (key == layout_keys.end()) return std::nullopt;
+	return hash_bytes(key->second.data(), sizeof(Key::value_type) * key->second.size());
+}
+
+uint32_t DescriptorSetLayoutCache::get_layout_count() const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return layouts.size();
+}
+} // namespace vkte
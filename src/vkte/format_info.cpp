@@ -0,0 +1,128 @@
+#include "vkte/format_info.hpp"
+
+#include <unordered_map>
+#include "vkte/vkte_log.hpp"
+
+namespace vkte
+{
+constexpr vk::ImageAspectFlags aspect_color = vk::ImageAspectFlagBits::eColor;
+constexpr vk::ImageAspectFlags aspect_depth = vk::ImageAspectFlagBits::eDepth;
+constexpr vk::ImageAspectFlags aspect_stencil = vk::ImageAspectFlagBits::eStencil;
+constexpr vk::ImageAspectFlags aspect_depth_stencil = vk::ImageAspectFlagBits::eDepth | vk::ImageAspectFlagBits::eStencil;
+
+const std::unordered_map<vk::Format, FormatInfo> format_infos = {
+	// 8 bit components
+	{vk::Format::eR8Unorm, {1, 1, 1, 1, ComponentType::UNorm, aspect_color}},
+	{vk::Format::eR8Snorm, {1, 1, 1, 1, ComponentType::SNorm, aspect_color}},
+	{vk::Format::eR8Uint, {1, 1, 1, 1, ComponentType::UInt, aspect_color}},
+	{vk::Format::eR8Sint, {1, 1, 1, 1, ComponentType::SInt, aspect_color}},
+	{vk::Format::eR8Srgb, {1, 1, 1, 1, ComponentType::SRGB, aspect_color}},
+	{vk::Format::eR8G8Unorm, {2, 1, 1, 2, ComponentType::UNorm, aspect_color}},
+	{vk::Format::eR8G8Snorm, {2, 1, 1, 2, ComponentType::SNorm, aspect_color}},
+	{vk::Format::eR8G8Uint, {2, 1, 1, 2, ComponentType::UInt, aspect_color}},
+	{vk::Format::eR8G8Sint, {2, 1, 1, 2, ComponentType::SInt, aspect_color}},
+	{vk::Format::eR8G8Srgb, {2, 1, 1, 2, ComponentType::SRGB, aspect_color}},
+	{vk::Format::eR8G8B8Unorm, {3, 1, 1, 3, ComponentType::UNorm, aspect_color}},
+	{vk::Format::eR8G8B8Srgb, {3, 1, 1, 3, ComponentType::SRGB, aspect_color}},
+	{vk::Format::eB8G8R8Unorm, {3, 1, 1, 3, ComponentType::UNorm, aspect_color}},
+	{vk::Format::eB8G8R8Srgb, {3, 1, 1, 3, ComponentType::SRGB, aspect_color}},
+	{vk::Format::eR8G8B8A8Unorm, {4, 1, 1, 4, ComponentType::UNorm, aspect_color}},
+	{vk::Format::eR8G8B8A8Snorm, {4, 1, 1, 4, ComponentType::SNorm, aspect_color}},
+	{vk::Format::eR8G8B8A8Uint, {4, 1, 1, 4, ComponentType::UInt, aspect_color}},
+	{vk::Format::eR8G8B8A8Sint, {4, 1, 1, 4, ComponentType::SInt, aspect_color}},
+	{vk::Format::eR8G8B8A8Srgb, {4, 1, 1, 4, ComponentType::SRGB, aspect_color}},
+	{vk::Format::eB8G8R8A8Unorm, {4, 1, 1, 4, ComponentType::UNorm, aspect_color}},
+	{vk::Format::eB8G8R8A8Srgb, {4, 1, 1, 4, ComponentType::SRGB, aspect_color}},
+	// 16 bit components
+	{vk::Format::eR16Unorm, {2, 1, 1, 1, ComponentType::UNorm, aspect_color}},
+	{vk::Format::eR16Snorm, {2, 1, 1, 1, ComponentType::SNorm, aspect_color}},
+	{vk::Format::eR16Uint, {2, 1, 1, 1, ComponentType::UInt, aspect_color}},
+	{vk::Format::eR16Sint, {2, 1, 1, 1, ComponentType::SInt, aspect_color}},
+	{vk::Format::eR16Sfloat, {2, 1, 1, 1, ComponentType::SFloat, aspect_color}},
+	{vk::Format::eR16G16Unorm, {4, 1, 1, 2, ComponentType::UNorm, aspect_color}},
+	{vk::Format::eR16G16Snorm, {4, 1, 1, 2, ComponentType::SNorm, aspect_color}},
+	{vk::Format::eR16G16Uint, {4, 1, 1, 2, ComponentType::UInt, aspect_color}},
+	{vk::Format::eR16G16Sint, {4, 1, 1, 2, ComponentType::SInt, aspect_color}},
+	{vk::Format::eR16G16Sfloat, {4, 1, 1, 2, ComponentType::SFloat, aspect_color}},
+	{vk::Format::eR16G16B16A16Unorm, {8, 1, 1, 4, ComponentType::UNorm, aspect_color}},
+	{vk::Format::eR16G16B16A16Snorm, {8, 1, 1, 4, ComponentType::SNorm, aspect_color}},
+	{vk::Format::eR16G16B16A16Uint, {8, 1, 1, 4, ComponentType::UInt, aspect_color}},
+	{vk::Format::eR16G16B16A16Sint, {8, 1, 1, 4, ComponentType::SInt, aspect_color}},
+	{vk::Format::eR16G16B16A16Sfloat, {8, 1, 1, 4, ComponentType::SFloat, aspect_color}},
+	// 32 bit components
+	{vk::Format::eR32Uint, {4, 1, 1, 1, ComponentType::UInt, aspect_color}},
+	{vk::Format::eR32Sint, {4, 1, 1, 1, ComponentType::SInt, aspect_color}},
+	{vk::Format::eR32Sfloat, {4, 1, 1, 1, ComponentType::SFloat, aspect_color}},
+	{vk::Format::eR32G32Uint, {8, 1, 1, 2, ComponentType::UInt, aspect_color}},
+	{vk::Format::eR32G32Sint, {8, 1, 1, 2, ComponentType::SInt, aspect_color}},
+	{vk::Format::eR32G32Sfloat, {8, 1, 1, 2, ComponentType::SFloat, aspect_color}},
+	{vk::Format::eR32G32B32Uint, {12, 1, 1, 3, ComponentType::UInt, aspect_color}},
+	{vk::Format::eR32G32B32Sint, {12, 1, 1, 3, ComponentType::SInt, aspect_color}},
+	{vk::Format::eR32G32B32Sfloat, {12, 1, 1, 3, ComponentType::SFloat, aspect_color}},
+	{vk::Format::eR32G32B32A32Uint, {16, 1, 1, 4, ComponentType::UInt, aspect_color}},
+	{vk::Format::eR32G32B32A32Sint, {16, 1, 1, 4, ComponentType::SInt, aspect_color}},
+	{vk::Format::eR32G32B32A32Sfloat, {16, 1, 1, 4, ComponentType::SFloat, aspect_color}},
+	// packed
+	{vk::Format::eA2B10G10R10UnormPack32, {4, 1, 1, 4, ComponentType::Opaque, aspect_color}},
+	{vk::Format::eA2R10G10B10UnormPack32, {4, 1, 1, 4, ComponentType::Opaque, aspect_color}},
+	{vk::Format::eB10G11R11UfloatPack32, {4, 1, 1, 3, ComponentType::Opaque, aspect_color}},
+	{vk::Format::eE5B9G9R9UfloatPack32, {4, 1, 1, 3, ComponentType::Opaque, aspect_color}},
+	// block compressed
+	{vk::Format::eBc1RgbUnormBlock, {8, 4, 4, 3, ComponentType::Opaque, aspect_color}},
+	{vk::Format::eBc1RgbSrgbBlock, {8, 4, 4, 3, ComponentType::Opaque, aspect_color}},
+	{vk::Format::eBc1RgbaUnormBlock, {8, 4, 4, 4, ComponentType::Opaque, aspect_color}},
+	{vk::Format::eBc1RgbaSrgbBlock, {8, 4, 4, 4, ComponentType::Opaque, aspect_color}},
+	{vk::Format::eBc2UnormBlock, {16, 4, 4, 4, ComponentType::Opaque, aspect_color}},
+	{vk::Format::eBc2SrgbBlock, {16, 4, 4, 4, ComponentType::Opaque, aspect_color}},
+	{vk::Format::eBc3UnormBlock, {16, 4, 4, 4, ComponentType::Opaque, aspect_color}},
+	{vk::Format::eBc3SrgbBlock, {16, 4, 4, 4, ComponentType::Opaque, aspect_color}},
+	{vk::Format::eBc4UnormBlock, {8, 4, 4, 1, ComponentType::Opaque, aspect_color}},
+	{vk::Format::eBc4SnormBlock, {8, 4, 4, 1, ComponentType::Opaque, aspect_color}},
+	{vk::Format::eBc5UnormBlock, {16, 4, 4, 2, ComponentType::Opaque, aspect_color}},
+	{vk::Format::eBc5SnormBlock, {16, 4, 4, 2, ComponentType::Opaque, aspect_color}},
+	{vk::Format::eBc6HUfloatBlock, {16, 4, 4, 3, ComponentType::Opaque, aspect_color}},
+	{vk::Format::eBc6HSfloatBlock, {16, 4, 4, 3, ComponentType::Opaque, aspect_color}},
+	{vk::Format::eBc7UnormBlock, {16, 4, 4, 4, ComponentType::Opaque, aspect_color}},
+	{vk::Format::eBc7SrgbBlock, {16, 4, 4, 4, ComponentType::Opaque, aspect_color}},
+	// depth stencil, the block size is the size of the texel in memory and not the size of a copied aspect
+	{vk::Format::eD16Unorm, {2, 1, 1, 1, ComponentType::Opaque, aspect_depth}},
+	{vk::Format::eX8D24UnormPack32, {4, 1, 1, 1, ComponentType::Opaque, aspect_depth}},
+	{vk::Format::eD32Sfloat, {4, 1, 1, 1, ComponentType::Opaque, aspect_depth}},
+	{vk::Format::eS8Uint, {1, 1, 1, 1, ComponentType::Opaque, aspect_stencil}},
+	{vk::Format::eD16UnormS8Uint, {3, 1, 1, 2, ComponentType::Opaque, aspect_depth_stencil}},
+	{vk::Format::eD24UnormS8Uint, {4, 1, 1, 2, ComponentType::Opaque, aspect_depth_stencil}},
+	{vk::Format::eD32SfloatS8Uint, {5, 1, 1, 2, ComponentType::Opaque, aspect_depth_stencil}}
+};
+
+const FormatInfo& get_format_info(vk::Format format)
+{
+	auto it = format_infos.find(format);
+	if (it == format_infos.end()) VKTE_THROW("vkte: Format " + vk::to_string(format) + " is not supported!");
+	return it->second;
+}
+
+vk::DeviceSize get_image_byte_size(vk::Format format, uint32_t width, uint32_t height, uint32_t depth)
+{
+	const FormatInfo& info = get_format_info(format);
+	const vk::DeviceSize blocks_x = (width + info.block_width - 1) / info.block_width;
+	const vk::DeviceSize blocks_y = (height + info.block_height - 1) / info.block_height;
+	return blocks_x * blocks_y * depth * info.block_byte_size;
+}
+
+uint32_t get_aspect_texel_byte_size(vk::Format format, vk::ImageAspectFlagBits aspect)
+{
+	const FormatInfo& info = get_format_info(format);
+	VKTE_ASSERT(info.aspect & aspect, "vkte: Format " + vk::to_string(format) + " has no " + vk::to_string(aspect) + " aspect!");
+	if (aspect == vk::ImageAspectFlagBits::eStencil) return 1;
+	if (aspect != vk::ImageAspectFlagBits::eDepth) return info.block_byte_size;
+	// the depth of D24 formats is copied in 4 bytes
+	switch (format)
+	{
+		case vk::Format::eD16Unorm:
+		case vk::Format::eD16UnormS8Uint:
+			return 2;
+		default:
+			return 4;
+	}
+}
+} // namespace vkte
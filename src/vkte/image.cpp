@@ -1,13 +1,18 @@
 #include "vkte/image.hpp"
 
+#include <algorithm>
+#include <array>
 #include <cmath>
+#include <type_traits>
 #include "vkte/buffer.hpp"
+#include "vkte/format_info.hpp"
+#include "vkte/pixel_conversion.hpp"
 
 namespace vkte
 {
 bool has_stencil(vk::Format depth_format)
 {
-	return depth_format == vk::Format::eD24UnormS8Uint || depth_format == vk::Format::eD32SfloatS8Uint;
+	return depth_format == vk::Format::eD16UnormS8Uint || depth_format == vk::Format::eD24UnormS8Uint || depth_format == vk::Format::eD32SfloatS8Uint;
 }
 
 vk::ImageAspectFlags default_aspect_for_format(vk::Format format)
@@ -15,10 +20,12 @@ vk::ImageAspectFlags default_aspect_for_format(vk::Format format)
 	switch (format)
 	{
 		case vk::Format::eD16Unorm:
+		case vk::Format::eX8D24UnormPack32:
 		case vk::Format::eD32Sfloat:
 			return vk::ImageAspectFlagBits::eDepth;
 		case vk::Format::eS8Uint:
 			return vk::ImageAspectFlagBits::eStencil;
+		case vk::Format::eD16UnormS8Uint:
 		case vk::Format::eD24UnormS8Uint:
 		case vk::Format::eD32SfloatS8Uint:
 			return vk::ImageAspectFlagBits::eDepth | vk::ImageAspectFlagBits::eStencil;
@@ -79,25 +86,72 @@ void perform_image_layout_transition(vk::CommandBuffer& cb, const std::vector<Im
 	cb.pipelineBarrier2(dep);
 }
 
-Image::Image(const VulkanMainContext& vmc, VulkanCommandContext& vcc, const unsigned char* data, uint32_t width, uint32_t height, bool use_mip_maps, uint32_t base_mip_map_lvl, Queues queues, vk::ImageUsageFlags usage_flags) : vmc(vmc), w(width), h(height), c(4), byte_size(width * height * 4), mip_levels(use_mip_maps ? std::floor(std::log2(std::max(w, h))) + 1 : 1), layer_count(1)
+void perform_image_barriers(vk::CommandBuffer& cb, const std::vector<vk::ImageMemoryBarrier2>& barriers)
 {
-	create_image_from_data(data, vcc, queues, base_mip_map_lvl, usage_flags);
+	if (barriers.empty()) return;
+	vk::DependencyInfo dep;
+	dep.imageMemoryBarrierCount = barriers.size();
+	dep.pImageMemoryBarriers = barriers.data();
+	cb.pipelineBarrier2(dep);
 }
 
-Image::Image(const VulkanMainContext& vmc, VulkanCommandContext& vcc, const std::vector<std::vector<unsigned char>>& data, uint32_t width, uint32_t height, bool use_mip_maps, uint32_t base_mip_map_lvl, Queues queues, vk::ImageUsageFlags usage_flags, vk::ImageViewType image_view_type) : vmc(vmc), w(width), h(height), c(4), byte_size(width * height * 4 * data.size()), mip_levels(use_mip_maps ? std::floor(std::log2(std::max(w, h))) + 1 : 1), layer_count(data.size())
+void require(vk::CommandBuffer& cb, const std::vector<ImageRequirement>& requirements)
 {
-	std::vector<unsigned char> copy_data;
-	for (const auto& i : data)
+	std::vector<vk::ImageMemoryBarrier2> barriers;
+	for (const ImageRequirement& r : requirements)
 	{
-		for (const auto& j : i) copy_data.push_back(j);
+		r.image->require(barriers, r.layout, r.stage, r.access, r.range.value_or(r.image->get_full_range()));
 	}
-	create_image_from_data(copy_data.data(), vcc, queues, base_mip_map_lvl, usage_flags, image_view_type);
+	perform_image_barriers(cb, barriers);
+}
+
+Image::Image(const VulkanMainContext& vmc, VulkanCommandContext& vcc, const unsigned char* data, uint32_t width, uint32_t height, bool use_mip_maps, uint32_t base_mip_map_lvl, Queues queues, vk::ImageUsageFlags usage_flags) : Image(vmc, vcc, static_cast<const void*>(data), vk::Format::eR8G8B8A8Unorm, width, height, use_mip_maps, base_mip_map_lvl, queues, usage_flags)
+{}
+
+Image::Image(const VulkanMainContext& vmc, VulkanCommandContext& vcc, const void* data, vk::Format format, uint32_t width, uint32_t height, bool use_mip_maps, uint32_t base_mip_map_lvl, Queues queues, vk::ImageUsageFlags usage_flags, PixelConversion conversion) : vmc(vmc), format(format), w(width), h(height), byte_size(get_image_byte_size(format, width, height)), mip_levels(use_mip_maps ? std::floor(std::log2(std::max(w, h))) + 1 : 1), layer_count(1)
+{
+	const std::size_t src_byte_size = conversion == PixelConversion::None ? byte_size : std::size_t(width) * height * get_source_texel_byte_size(conversion, get_format_info(format));
+	const std::span<const unsigned char> layer(static_cast<const unsigned char*>(data), src_byte_size);
+	create_image_from_data({&layer, 1}, vcc, queues, base_mip_map_lvl, usage_flags, vk::ImageViewType::e2D, conversion);
+}
+
+static std::vector<std::span<const unsigned char>> get_layer_spans(const std::vector<std::vector<unsigned char>>& data)
+{
+	return std::vector<std::span<const unsigned char>>(data.begin(), data.end());
+}
+
+Image::Image(const VulkanMainContext& vmc, VulkanCommandContext& vcc, const std::vector<std::vector<unsigned char>>& data, uint32_t width, uint32_t height, bool use_mip_maps, uint32_t base_mip_map_lvl, Queues queues, vk::ImageUsageFlags usage_flags, vk::ImageViewType image_view_type) : Image(vmc, vcc, get_layer_spans(data), vk::Format::eR8G8B8A8Unorm, width, height, use_mip_maps, base_mip_map_lvl, queues, usage_flags, image_view_type)
+{}
+
+Image::Image(const VulkanMainContext& vmc, VulkanCommandContext& vcc, std::span<const std::span<const unsigned char>> layers, uint32_t width, uint32_t height, bool use_mip_maps, uint32_t base_mip_map_lvl, Queues queues, vk::ImageUsageFlags usage_flags, vk::ImageViewType image_view_type) : Image(vmc, vcc, layers, vk::Format::eR8G8B8A8Unorm, width, height, use_mip_maps, base_mip_map_lvl, queues, usage_flags, image_view_type)
+{}
+
+Image::Image(const VulkanMainContext& vmc, VulkanCommandContext& vcc, std::span<const std::span<const unsigned char>> layers, vk::Format format, uint32_t width, uint32_t height, bool use_mip_maps, uint32_t base_mip_map_lvl, Queues queues, vk::ImageUsageFlags usage_flags, vk::ImageViewType image_view_type, PixelConversion conversion) : vmc(vmc), format(format), w(width), h(height), byte_size(get_image_byte_size(format, width, height) * layers.size()), mip_levels(use_mip_maps ? std::floor(std::log2(std::max(w, h))) + 1 : 1), layer_count(layers.size())
+{
+	VKTE_ASSERT(!layers.empty(), "vkte: Image needs at least one layer!");
+	create_image_from_data(layers, vcc, queues, base_mip_map_lvl, usage_flags, image_view_type, conversion);
+}
+
+Image::Image(const VulkanMainContext& vmc, VulkanCommandContext& vcc, const std::function<void(uint32_t first_slice, uint32_t slice_count, unsigned char* dst)>& load_slices, vk::Format format, vk::Extent3D extent, bool use_mip_maps, Queues queues, vk::ImageUsageFlags usage_flags, vk::DeviceSize staging_byte_size) : vmc(vmc), format(format), w(extent.width), h(extent.height), d(extent.depth), mip_levels(use_mip_maps ? std::floor(std::log2(std::max({w, h, d}))) + 1 : 1), layer_count(1), byte_size(get_image_byte_size(format, extent.width, extent.height, extent.depth))
+{
+	create_volume_from_data(load_slices, vcc, queues, usage_flags, staging_byte_size);
 }
 
-Image::Image(const VulkanMainContext& vmc, const VulkanCommandContext& vcc, uint32_t width, uint32_t height, vk::ImageUsageFlags usage, vk::Format format, vk::SampleCountFlagBits sample_count, bool use_mip_maps, uint32_t base_mip_map_lvl, Queues queues, bool image_view_required, uint32_t layer_count) : vmc(vmc), format(format), w(width), h(height), c(4), mip_levels(use_mip_maps ? std::floor(std::log2(std::max(w, h))) + 1 : 1), layer_count(layer_count)
+Image::Image(const VulkanMainContext& vmc, VulkanCommandContext& vcc, const void* data, vk::Format format, vk::Extent3D extent, bool use_mip_maps, Queues queues, vk::ImageUsageFlags usage_flags, vk::DeviceSize staging_byte_size) : Image(vmc, vcc, [&](uint32_t first_slice, uint32_t slice_count, unsigned char* dst) {
+	const vk::DeviceSize slice_byte_size = get_image_byte_size(format, extent.width, extent.height);
+	memcpy(dst, static_cast<const unsigned char*>(data) + first_slice * slice_byte_size, slice_count * slice_byte_size);
+}, format, extent, use_mip_maps, queues, usage_flags, staging_byte_size)
+{}
+
+Image::Image(const VulkanMainContext& vmc, const VulkanCommandContext& vcc, uint32_t width, uint32_t height, vk::ImageUsageFlags usage, vk::Format format, vk::SampleCountFlagBits sample_count, bool use_mip_maps, uint32_t base_mip_map_lvl, Queues queues, bool image_view_required, uint32_t layer_count, vk::ImageCreateFlags create_flags) : vmc(vmc), format(format), w(width), h(height), mip_levels(use_mip_maps ? std::floor(std::log2(std::max(w, h))) + 1 : 1), layer_count(layer_count)
 {
-	std::tie(image, vmaa) = create_image(queues, usage, sample_count, use_mip_maps, format, vk::Extent3D(w, h, 1), layer_count, vmc.va, !image_view_required);
-	layout = vk::ImageLayout::eUndefined;
+	if (usage & vk::ImageUsageFlagBits::eTransientAttachment)
+	{
+		const vk::ImageUsageFlags transient_usage = vk::ImageUsageFlagBits::eTransientAttachment | vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eDepthStencilAttachment | vk::ImageUsageFlagBits::eInputAttachment;
+		VKTE_ASSERT(!(usage & ~transient_usage) && !use_mip_maps && image_view_required, "vkte: Transient attachments can only be used as attachments!");
+	}
+	std::tie(image, vmaa) = create_image(queues, usage, sample_count, use_mip_maps, format, vk::Extent3D(w, h, 1), layer_count, vmc.va, !image_view_required, create_flags);
+	subresource_states.assign(std::size_t(mip_levels) * layer_count, {});
 	if(image_view_required) create_image_view(default_aspect_for_format(format));
 }
 
@@ -133,15 +187,15 @@ void copy_image(vk::CommandBuffer& cb, vk::Image& src, vk::Image& dst, uint32_t
 	cb.copyImage(src, vk::ImageLayout::eTransferSrcOptimal, dst, vk::ImageLayout::eTransferDstOptimal, 1, &ic);
 }
 
-std::pair<vk::Image, VmaAllocation> Image::create_image(Queues queues, vk::ImageUsageFlags usage, vk::SampleCountFlagBits sample_count, bool use_mip_levels, vk::Format format, vk::Extent3D extent, uint32_t layer_count, const VmaAllocator& va, bool host_visible)
+std::pair<vk::Image, VmaAllocation> Image::create_image(Queues queues, vk::ImageUsageFlags usage, vk::SampleCountFlagBits sample_count, bool use_mip_levels, vk::Format format, vk::Extent3D extent, uint32_t layer_count, const VmaAllocator& va, bool host_visible, vk::ImageCreateFlags create_flags)
 {
 	std::vector<uint32_t> queue_family_indices = vmc.queue_families.get(queues);
-	uint32_t mip_levels = use_mip_levels ? std::floor(std::log2(std::max(extent.width, extent.height))) + 1 : 1;
+	VKTE_ASSERT(extent.depth == 1 || layer_count == 1, "vkte: 3D images cannot have multiple layers!");
+	uint32_t mip_levels = use_mip_levels ? std::floor(std::log2(std::max({extent.width, extent.height, extent.depth}))) + 1 : 1;
 	if (mip_levels > 1) usage |= vk::ImageUsageFlagBits::eTransferSrc;
 	vk::ImageCreateInfo ici;
-	ici.imageType = vk::ImageType::e2D;
+	ici.imageType = extent.depth > 1 ? vk::ImageType::e3D : vk::ImageType::e2D;
 	ici.extent = extent;
-	ici.extent.depth = 1;
 	ici.mipLevels = mip_levels;
 	ici.arrayLayers = layer_count;
 	ici.format = format;
@@ -152,9 +206,16 @@ std::pair<vk::Image, VmaAllocation> Image::create_image(Queues queues, vk::Image
 	ici.queueFamilyIndexCount = queue_family_indices.size();
 	ici.pQueueFamilyIndices = queue_family_indices.data();
 	ici.samples = sample_count;
-	ici.flags = {};
+	ici.flags = create_flags;
 
 	std::pair<vk::Image, VmaAllocation> image;
+	if (create_flags & vk::ImageCreateFlagBits::eSparseBinding)
+	{
+		// sparse images are not bound to a single allocation
+		image.first = vmc.logical_device.get().createImage(ici);
+		image.second = VK_NULL_HANDLE;
+		return image;
+	}
 	VmaAllocationCreateInfo vaci{};
 	if (host_visible)
 	{
@@ -164,20 +225,21 @@ std::pair<vk::Image, VmaAllocation> Image::create_image(Queues queues, vk::Image
 	{
 		vaci.usage = VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE;
 		vaci.requiredFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+		// transient attachments are backed by physical memory only when needed on tile-based hardware, the memory type is only used if available
+		if (usage & vk::ImageUsageFlagBits::eTransientAttachment) vaci.preferredFlags = VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT;
 		vaci.flags = VMA_ALLOCATION_CREATE_DEDICATED_MEMORY_BIT;
 	}
 	vmaCreateImage(va, (VkImageCreateInfo*) (&ici), &vaci, (VkImage*) (&image.first), &image.second, nullptr);
 	return image;
 }
 
-void copy_buffer_to_image(VulkanCommandContext& vcc, const Buffer& buffer, vk::Extent3D extent, vk::Image image, uint32_t layer_count, uint32_t pixel_byte_size)
+void copy_buffer_to_image(vk::CommandBuffer& cb, const Buffer& buffer, vk::Extent3D extent, vk::Image image, uint32_t layer_count, vk::DeviceSize layer_byte_size)
 {
-	vk::CommandBuffer& cb = vcc.get_one_time_transfer_buffer();
 	std::vector<vk::BufferImageCopy> copy_regions;
 	for (uint32_t i = 0; i < layer_count; ++i)
 	{
 		vk::BufferImageCopy copy_region{};
-		copy_region.bufferOffset = i * extent.width * extent.height * pixel_byte_size;
+		copy_region.bufferOffset = i * layer_byte_size;
 		copy_region.bufferRowLength = 0;
 		copy_region.bufferImageHeight = 0;
 		copy_region.imageSubresource.aspectMask = vk::ImageAspectFlagBits::eColor;
@@ -190,111 +252,362 @@ void copy_buffer_to_image(VulkanCommandContext& vcc, const Buffer& buffer, vk::E
 	}
 
 	cb.copyBufferToImage(buffer.get(), image, vk::ImageLayout::eTransferDstOptimal, copy_regions);
-	vcc.submit_transfer(cb, true);
 }
 
-void Image::create_image_from_data(const unsigned char* data, VulkanCommandContext& vcc, Queues queues, uint32_t base_mip_map_lvl, vk::ImageUsageFlags usage_flags, vk::ImageViewType image_view_type)
+// half floats are averaged in single precision
+struct Half
 {
-	Buffer buffer(vmc, vcc, data, byte_size, vk::BufferUsageFlagBits::eTransferSrc, false, QueueFamilyFlags::Transfer);
+	uint16_t bits;
+};
 
-	vk::FormatProperties format_properties = vmc.physical_device.get().getFormatProperties(format);
-	if (!(format_properties.optimalTilingFeatures & vk::FormatFeatureFlagBits::eSampledImageFilterLinear))
+template<typename T>
+T average(T a, T b, T c, T d)
+{
+	if constexpr (std::is_floating_point_v<T>)
 	{
-		mip_levels = 1;
-		base_mip_map_lvl = 0;
+		return (a + b + c + d) * T(0.25);
+	}
+	else
+	{
+		// small types accumulate in 32 bit so that the loop stays vectorizable, the arithmetic shift rounds to nearest for signed values too
+		using Accumulator = std::conditional_t<(sizeof(T) < 4), int32_t, int64_t>;
+		return T((Accumulator(a) + b + c + d + 2) >> 2);
 	}
+}
 
-	auto move_buffer_to_image = [&](vk::Image image, uint32_t mip_levels) -> void {
-		// copy image data to tmp_image
-		vk::CommandBuffer& cb = vcc.get_one_time_transfer_buffer();
-		perform_image_layout_transition(cb, {
-			.image = image,
-			.range = {
-				.aspect = vk::ImageAspectFlagBits::eColor,
-				.base_mip_level = 0,
-				.level_count = mip_levels,
-				.base_array_layer = 0,
-				.layer_count = layer_count
-			},
-			.old_layout = vk::ImageLayout::eUndefined,
-			.new_layout = vk::ImageLayout::eTransferDstOptimal,
-			.src_stage = vk::PipelineStageFlagBits2::eTransfer,
-			.src_access = vk::AccessFlagBits2::eNone,
-			.dst_stage = vk::PipelineStageFlagBits2::eTransfer,
-			.dst_access = vk::AccessFlagBits2::eTransferWrite
-		});
-		vcc.submit_transfer(cb, true);
-		copy_buffer_to_image(vcc, buffer, vk::Extent3D(w, h, 1), image, layer_count, c);
-	};
+Half average(Half a, Half b, Half c, Half d)
+{
+	return {float_to_half((half_to_float(a.bits) + half_to_float(b.bits) + half_to_float(c.bits) + half_to_float(d.bits)) * 0.25f)};
+}
+
+// halve the resolution of data with a 2x2 box filter, the last row and column of odd sizes are dropped
+// the component count C is a template parameter, so that the loop over the components is unrolled and the loop over the pixels can be vectorized
+template<typename T, uint32_t C>
+void downsample_box(const unsigned char* src_data, uint32_t src_width, uint32_t src_height, uint32_t, unsigned char* dst_data)
+{
+	const T* src = reinterpret_cast<const T*>(src_data);
+	T* dst = reinterpret_cast<T*>(dst_data);
+	const uint32_t dst_width = std::max(1u, src_width / 2);
+	const uint32_t dst_height = std::max(1u, src_height / 2);
+	// the clamped offsets handle sources that are only one pixel wide or high
+	const std::size_t x_step = src_width > 1 ? C : 0;
+	const std::size_t y_step = src_height > 1 ? std::size_t(src_width) * C : 0;
+	for (uint32_t y = 0; y < dst_height; ++y)
+	{
+		const T* row_0 = src + std::size_t(y) * 2 * src_width * C;
+		const T* row_1 = row_0 + y_step;
+		T* dst_row = dst + std::size_t(y) * dst_width * C;
+		for (uint32_t x = 0; x < dst_width; ++x)
+		{
+			const T* p_0 = row_0 + std::size_t(x) * 2 * C;
+			const T* p_1 = row_1 + std::size_t(x) * 2 * C;
+			for (uint32_t c = 0; c < C; ++c) dst_row[std::size_t(x) * C + c] = average(p_0[c], p_0[c + x_step], p_1[c], p_1[c + x_step]);
+		}
+	}
+}
+
+// like downsample_box, but the color components are averaged in linear space like the blit of the gpu does, alpha is always linear
+template<uint32_t C>
+void downsample_box_srgb(const unsigned char* src, uint32_t src_width, uint32_t src_height, uint32_t, unsigned char* dst)
+{
+	const uint32_t dst_width = std::max(1u, src_width / 2);
+	const uint32_t dst_height = std::max(1u, src_height / 2);
+	const std::size_t x_step = src_width > 1 ? C : 0;
+	const std::size_t y_step = src_height > 1 ? std::size_t(src_width) * C : 0;
+	for (uint32_t y = 0; y < dst_height; ++y)
+	{
+		const unsigned char* row_0 = src + std::size_t(y) * 2 * src_width * C;
+		const unsigned char* row_1 = row_0 + y_step;
+		unsigned char* dst_row = dst + std::size_t(y) * dst_width * C;
+		for (uint32_t x = 0; x < dst_width; ++x)
+		{
+			const unsigned char* p_0 = row_0 + std::size_t(x) * 2 * C;
+			const unsigned char* p_1 = row_1 + std::size_t(x) * 2 * C;
+			for (uint32_t c = 0; c < C; ++c)
+			{
+				if (C == 4 && c == 3) dst_row[std::size_t(x) * C + c] = average(p_0[c], p_0[c + x_step], p_1[c], p_1[c + x_step]);
+				else dst_row[std::size_t(x) * C + c] = linear_to_srgb8((srgb8_to_linear(p_0[c]) + srgb8_to_linear(p_0[c + x_step]) + srgb8_to_linear(p_1[c]) + srgb8_to_linear(p_1[c + x_step])) * 0.25f);
+			}
+		}
+	}
+}
+
+using DownsampleFunction = void (*)(const unsigned char*, uint32_t, uint32_t, uint32_t, unsigned char*);
+
+template<typename T>
+DownsampleFunction get_downsample_box(uint32_t component_count)
+{
+	switch (component_count)
+	{
+		case 1:
+			return downsample_box<T, 1>;
+		case 2:
+			return downsample_box<T, 2>;
+		case 3:
+			return downsample_box<T, 3>;
+		case 4:
+			return downsample_box<T, 4>;
+		default:
+			return nullptr;
+	}
+}
+
+DownsampleFunction get_downsample_box_srgb(uint32_t component_count)
+{
+	switch (component_count)
+	{
+		case 1:
+			return downsample_box_srgb<1>;
+		case 2:
+			return downsample_box_srgb<2>;
+		case 3:
+			return downsample_box_srgb<3>;
+		case 4:
+			return downsample_box_srgb<4>;
+		default:
+			return nullptr;
+	}
+}
+
+// select the box filter for the component type of the format, returns nullptr if the format cannot be filtered per component
+DownsampleFunction get_downsample_function(const FormatInfo& info)
+{
+	if (info.component_type == ComponentType::Opaque || info.block_width != 1 || info.block_height != 1) return nullptr;
+	if (info.component_type == ComponentType::SRGB) return info.block_byte_size == info.component_count ? get_downsample_box_srgb(info.component_count) : nullptr;
+	const bool is_signed = info.component_type == ComponentType::SNorm || info.component_type == ComponentType::SInt;
+	switch (info.block_byte_size / info.component_count)
+	{
+		case 1:
+			return is_signed ? get_downsample_box<int8_t>(info.component_count) : get_downsample_box<uint8_t>(info.component_count);
+		case 2:
+			if (info.component_type == ComponentType::SFloat) return get_downsample_box<Half>(info.component_count);
+			return is_signed ? get_downsample_box<int16_t>(info.component_count) : get_downsample_box<uint16_t>(info.component_count);
+		case 4:
+			if (info.component_type == ComponentType::SFloat) return get_downsample_box<float>(info.component_count);
+			return is_signed ? get_downsample_box<int32_t>(info.component_count) : get_downsample_box<uint32_t>(info.component_count);
+		default:
+			return nullptr;
+	}
+}
+
+// reduce the resolution of data by level_count mip levels, intermediate levels are stored in scratch buffers
+void downsample(DownsampleFunction downsample_level, const unsigned char* src, uint32_t width, uint32_t height, uint32_t component_count, uint32_t texel_byte_size, uint32_t level_count, unsigned char* dst, std::array<std::vector<unsigned char>, 2>& scratch)
+{
+	const unsigned char* level_src = src;
+	for (uint32_t i = 0; i < level_count; ++i)
+	{
+		unsigned char* level_dst = dst;
+		if (i + 1 < level_count)
+		{
+			scratch[i % 2].resize(std::size_t(std::max(1u, width / 2)) * std::max(1u, height / 2) * texel_byte_size);
+			level_dst = scratch[i % 2].data();
+		}
+		downsample_level(level_src, width, height, component_count, level_dst);
+		level_src = level_dst;
+		width = std::max(1u, width / 2);
+		height = std::max(1u, height / 2);
+	}
+}
+
+void Image::create_image_from_data(std::span<const std::span<const unsigned char>> layers, VulkanCommandContext& vcc, Queues queues, uint32_t base_mip_map_lvl, vk::ImageUsageFlags usage_flags, vk::ImageViewType image_view_type, PixelConversion conversion)
+{
+	const FormatInfo& format_info = get_format_info(format);
+	VKTE_ASSERT(format_info.aspect == vk::ImageAspectFlagBits::eColor, "vkte: Only images with color formats can be created from data!");
+	VKTE_ASSERT(is_conversion_valid(conversion, format_info), "vkte: Pixel conversion does not produce texels of format " + vk::to_string(format) + "!");
+	// mip maps are generated by linear blits, which are not supported by all formats (e.g. integer formats)
+	vk::FormatProperties format_properties = vmc.physical_device.get().getFormatProperties(format);
+	const vk::FormatFeatureFlags blit_features = vk::FormatFeatureFlagBits::eBlitSrc | vk::FormatFeatureFlagBits::eBlitDst | vk::FormatFeatureFlagBits::eSampledImageFilterLinear;
+	const bool linear_filtering = bool(format_properties.optimalTilingFeatures & vk::FormatFeatureFlagBits::eSampledImageFilterLinear);
+	if ((format_properties.optimalTilingFeatures & blit_features) != blit_features) mip_levels = 1;
 
 	// check if image should start at base_mip_map_lvl to save some storage
-	// create image with original resolution and copy to actual image with reduced resolution
+	// the resolution is reduced on the CPU so that only the reduced resolution is uploaded
+	const DownsampleFunction downsample_level = get_downsample_function(format_info);
+	if (base_mip_map_lvl > 0 && !downsample_level)
+	{
+		VKTE_WARN("vkte: Format {} cannot be downsampled, the base mip map level is ignored!", vk::to_string(format));
+		base_mip_map_lvl = 0;
+	}
+	const uint32_t src_w = w;
+	const uint32_t src_h = h;
+	const vk::DeviceSize src_layer_byte_size = conversion == PixelConversion::None ? get_image_byte_size(format, src_w, src_h) : vk::DeviceSize(src_w) * src_h * get_source_texel_byte_size(conversion, format_info);
 	if (base_mip_map_lvl > 0)
 	{
-		auto [tmp_image, tmp_alloc] = create_image(QueueFamilyFlags::Graphics | QueueFamilyFlags::Transfer, vk::ImageUsageFlagBits::eTransferDst | vk::ImageUsageFlagBits::eTransferSrc, vk::SampleCountFlagBits::e1, false, format, vk::Extent3D(w, h, 1), layer_count, vmc.va);
-		move_buffer_to_image(tmp_image, 1);
-
-		vk::Offset3D tmp_image_offset(w, h, 1);
-		mip_levels -= base_mip_map_lvl;
-		w = std::max(1.0, w / (std::pow(2, base_mip_map_lvl)));
-		h = std::max(1.0, h / (std::pow(2, base_mip_map_lvl)));
-		byte_size = w * h * 4;
-
-		// create image with reduced resolution by blitting
-		vk::CommandBuffer& cb = vcc.get_one_time_graphics_buffer();
-		perform_image_layout_transition(cb, {
-			.image = tmp_image,
-			.range = {
-				.aspect = vk::ImageAspectFlagBits::eColor,
-				.base_mip_level = 0,
-				.level_count = 1,
-				.base_array_layer = 0,
-				.layer_count = layer_count
-			},
-			.old_layout = vk::ImageLayout::eTransferDstOptimal,
-			.new_layout = vk::ImageLayout::eTransferSrcOptimal,
-			.src_stage = vk::PipelineStageFlagBits2::eTransfer,
-			.src_access = vk::AccessFlagBits2::eTransferWrite,
-			.dst_stage = vk::PipelineStageFlagBits2::eTransfer,
-			.dst_access = vk::AccessFlagBits2::eTransferRead
-		});
-		std::tie(image, vmaa) = create_image(queues, vk::ImageUsageFlagBits::eTransferDst | vk::ImageUsageFlagBits::eTransferSrc | usage_flags, vk::SampleCountFlagBits::e1, true, format, vk::Extent3D(w, h, 1), layer_count, vmc.va);
-		perform_image_layout_transition(cb, {
-			.image = image,
-			.range = {
-				.aspect = vk::ImageAspectFlagBits::eColor,
-				.base_mip_level = 0,
-				.level_count = mip_levels,
-				.base_array_layer = 0,
-				.layer_count = layer_count
-			},
-			.old_layout = vk::ImageLayout::eUndefined,
-			.new_layout = vk::ImageLayout::eTransferDstOptimal,
-			.src_stage = vk::PipelineStageFlagBits2::eTransfer,
-			.src_access = vk::AccessFlagBits2::eNone,
-			.dst_stage = vk::PipelineStageFlagBits2::eTransfer,
-			.dst_access = vk::AccessFlagBits2::eTransferWrite
-		});
-		blit_image(cb, tmp_image, 0, tmp_image_offset, image, 0, {w, h, 1}, layer_count);
-		vcc.submit_graphics(cb, true);
-
-		vmaDestroyImage(vmc.va, VkImage(tmp_image), tmp_alloc);
+		mip_levels = mip_levels > base_mip_map_lvl ? mip_levels - base_mip_map_lvl : 1;
+		w = std::max(1u, src_w >> base_mip_map_lvl);
+		h = std::max(1u, src_h >> base_mip_map_lvl);
+		byte_size = get_image_byte_size(format, w, h) * layer_count;
 	}
-	else
+
+	const vk::ImageLayout host_copy_layout = (usage_flags & vk::ImageUsageFlagBits::eSampled) ? vk::ImageLayout::eShaderReadOnlyOptimal : vk::ImageLayout::eTransferDstOptimal;
+	const vk::ImageUsageFlags host_copy_usage = vk::ImageUsageFlagBits::eTransferDst | vk::ImageUsageFlagBits::eTransferSrc | vk::ImageUsageFlagBits::eHostTransfer | usage_flags;
+	// the mip maps of host copies are generated on the CPU, as no command buffer is recorded
+	if ((mip_levels == 1 || downsample_level) && is_host_image_copy_usable(host_copy_usage, host_copy_layout))
 	{
-		// layout of image is transitioned in move_buffer_to_image
-		std::tie(image, vmaa) = create_image(queues, vk::ImageUsageFlagBits::eTransferDst | vk::ImageUsageFlagBits::eTransferSrc | usage_flags, vk::SampleCountFlagBits::e1, true, format, vk::Extent3D(w, h, 1), layer_count, vmc.va);
-		move_buffer_to_image(image, mip_levels);
+		std::tie(image, vmaa) = create_image(queues, host_copy_usage, vk::SampleCountFlagBits::e1, mip_levels > 1, format, vk::Extent3D(w, h, 1), layer_count, vmc.va);
+		subresource_states.assign(std::size_t(mip_levels) * layer_count, SubresourceState{.layout = host_copy_layout});
+		vk::HostImageLayoutTransitionInfo transition;
+		transition.image = image;
+		transition.oldLayout = vk::ImageLayout::eUndefined;
+		transition.newLayout = host_copy_layout;
+		transition.subresourceRange = vk::ImageSubresourceRange(vk::ImageAspectFlagBits::eColor, 0, mip_levels, 0, layer_count);
+		vmc.logical_device.get().transitionImageLayout(transition);
+
+		std::array<std::vector<unsigned char>, 2> scratch;
+		std::array<std::vector<unsigned char>, 2> levels;
+		std::vector<unsigned char> converted;
+		for (uint32_t i = 0; i < layer_count; ++i)
+		{
+			VKTE_ASSERT(layers[i].size() >= src_layer_byte_size, "vkte: Image layer contains less data than required!");
+			// unconverted data of the base level is copied straight from the source
+			const unsigned char* level_src = layers[i].data();
+			if (conversion != PixelConversion::None)
+			{
+				converted.resize(get_image_byte_size(format, src_w, src_h));
+				convert_pixels(conversion, level_src, converted.data(), std::size_t(src_w) * src_h, format_info);
+				level_src = converted.data();
+			}
+			if (base_mip_map_lvl > 0)
+			{
+				levels[0].resize(get_image_byte_size(format, w, h));
+				downsample(downsample_level, level_src, src_w, src_h, format_info.component_count, format_info.block_byte_size, base_mip_map_lvl, levels[0].data(), scratch);
+				level_src = levels[0].data();
+			}
+			for (uint32_t level = 0; level < mip_levels; ++level)
+			{
+				const uint32_t level_w = std::max(1, w >> level);
+				const uint32_t level_h = std::max(1, h >> level);
+				vk::MemoryToImageCopy region;
+				region.pHostPointer = level_src;
+				region.imageSubresource = vk::ImageSubresourceLayers(vk::ImageAspectFlagBits::eColor, level, i, 1);
+				region.imageExtent = vk::Extent3D(level_w, level_h, 1);
+				vk::CopyMemoryToImageInfo copy_info;
+				copy_info.dstImage = image;
+				copy_info.dstImageLayout = host_copy_layout;
+				copy_info.setRegions(region);
+				vmc.logical_device.get().copyMemoryToImage(copy_info);
+				if (level + 1 == mip_levels) break;
+				std::vector<unsigned char>& next_level = levels[(level + 1) % 2];
+				next_level.resize(get_image_byte_size(format, std::max(1u, level_w / 2), std::max(1u, level_h / 2)));
+				downsample_level(level_src, level_w, level_h, format_info.component_count, next_level.data());
+				level_src = next_level.data();
+			}
+		}
+		create_image_view(vk::ImageAspectFlagBits::eColor, image_view_type);
+		create_sampler(linear_filtering ? vk::Filter::eLinear : vk::Filter::eNearest);
+		return;
 	}
-	buffer.destruct();
-	// set current layout of this image
-	layout = vk::ImageLayout::eTransferDstOptimal;
+
+	// write every layer directly to its final offset in the staging buffer, the pixel conversion is applied while writing
+	Buffer buffer(vmc, vcc, byte_size, vk::BufferUsageFlagBits::eTransferSrc, false, QueueFamilyFlags::Transfer);
+	const vk::DeviceSize layer_byte_size = byte_size / layer_count;
+	unsigned char* staging_data = static_cast<unsigned char*>(buffer.map());
+	std::array<std::vector<unsigned char>, 2> scratch;
+	std::vector<unsigned char> converted;
+	for (uint32_t i = 0; i < layer_count; ++i)
+	{
+		VKTE_ASSERT(layers[i].size() >= src_layer_byte_size, "vkte: Image layer contains less data than required!");
+		unsigned char* layer_dst = staging_data + i * layer_byte_size;
+		if (base_mip_map_lvl == 0)
+		{
+			if (conversion == PixelConversion::None) memcpy(layer_dst, layers[i].data(), layer_byte_size);
+			else convert_pixels(conversion, layers[i].data(), layer_dst, std::size_t(w) * h, format_info);
+			continue;
+		}
+		// the full resolution has to be converted before it can be downsampled
+		const unsigned char* layer_src = layers[i].data();
+		if (conversion != PixelConversion::None)
+		{
+			converted.resize(get_image_byte_size(format, src_w, src_h));
+			convert_pixels(conversion, layer_src, converted.data(), std::size_t(src_w) * src_h, format_info);
+			layer_src = converted.data();
+		}
+		downsample(downsample_level, layer_src, src_w, src_h, format_info.component_count, format_info.block_byte_size, base_mip_map_lvl, layer_dst, scratch);
+	}
+	buffer.unmap();
+
+	// record the whole upload into one command buffer, if no upload batch is open the upload is submitted at the end of this function
+	const bool batched = vcc.is_upload_batch_open();
+	if (!batched) vcc.begin_upload_batch();
+	vk::CommandBuffer& cb = vcc.get_upload_buffer();
+
+	std::tie(image, vmaa) = create_image(queues, vk::ImageUsageFlagBits::eTransferDst | vk::ImageUsageFlagBits::eTransferSrc | usage_flags, vk::SampleCountFlagBits::e1, mip_levels > 1, format, vk::Extent3D(w, h, 1), layer_count, vmc.va);
+	subresource_states.assign(std::size_t(mip_levels) * layer_count, {});
+	// only the first mip level is written by the copy, the other levels are transitioned while generating the mip maps
+	require(cb, vk::ImageLayout::eTransferDstOptimal, vk::PipelineStageFlagBits2::eTransfer, vk::AccessFlagBits2::eTransferWrite, {.aspect = vk::ImageAspectFlagBits::eColor, .base_mip_level = 0, .level_count = 1, .base_array_layer = 0, .layer_count = layer_count});
+	copy_buffer_to_image(cb, buffer, vk::Extent3D(w, h, 1), image, layer_count, layer_byte_size);
+	vcc.defer_until_upload_submitted([buffer]() mutable { buffer.destruct(); });
 	if (usage_flags & vk::ImageUsageFlagBits::eSampled)
 	{
-		mip_levels > 1 ? generate_mipmaps(vcc) : transition_image_layout(vcc, vk::ImageLayout::eShaderReadOnlyOptimal, vk::PipelineStageFlagBits2::eTransfer, vk::PipelineStageFlagBits2::eFragmentShader, vk::AccessFlagBits2::eTransferWrite, vk::AccessFlagBits2::eShaderRead);
+		if (mip_levels > 1) generate_mipmaps(cb);
+		else require(cb, vk::ImageLayout::eShaderReadOnlyOptimal, vk::PipelineStageFlagBits2::eFragmentShader, vk::AccessFlagBits2::eShaderRead);
 	}
+	if (!batched) vcc.submit_upload_batch();
 	create_image_view(vk::ImageAspectFlagBits::eColor, image_view_type);
-	create_sampler();
+	create_sampler(linear_filtering ? vk::Filter::eLinear : vk::Filter::eNearest);
+}
+
+void Image::create_volume_from_data(const std::function<void(uint32_t, uint32_t, unsigned char*)>& load_slices, VulkanCommandContext& vcc, Queues queues, vk::ImageUsageFlags usage_flags, vk::DeviceSize staging_byte_size)
+{
+	VKTE_ASSERT(get_format_info(format).aspect == vk::ImageAspectFlagBits::eColor, "vkte: Only images with color formats can be created from data!");
+	// mip maps are generated by linear blits, which are not supported by all formats (e.g. integer formats)
+	vk::FormatProperties format_properties = vmc.physical_device.get().getFormatProperties(format);
+	const vk::FormatFeatureFlags blit_features = vk::FormatFeatureFlagBits::eBlitSrc | vk::FormatFeatureFlagBits::eBlitDst | vk::FormatFeatureFlagBits::eSampledImageFilterLinear;
+	const bool linear_filtering = bool(format_properties.optimalTilingFeatures & vk::FormatFeatureFlagBits::eSampledImageFilterLinear);
+	if ((format_properties.optimalTilingFeatures & blit_features) != blit_features) mip_levels = 1;
+
+	std::tie(image, vmaa) = create_image(queues, vk::ImageUsageFlagBits::eTransferDst | vk::ImageUsageFlagBits::eTransferSrc | usage_flags, vk::SampleCountFlagBits::e1, mip_levels > 1, format, vk::Extent3D(w, h, d), 1, vmc.va);
+	subresource_states.assign(mip_levels, {});
+
+	// the staging buffer holds whole slices, so the volume is limited by device memory only and not by the staging memory
+	const vk::DeviceSize slice_byte_size = get_image_byte_size(format, w, h);
+	const uint32_t slab_slice_count = std::clamp<vk::DeviceSize>(staging_byte_size / slice_byte_size, 1, d);
+	Buffer buffer(vmc, vcc, slice_byte_size * slab_slice_count, vk::BufferUsageFlagBits::eTransferSrc, false, QueueFamilyFlags::Transfer);
+	unsigned char* staging_data = static_cast<unsigned char*>(buffer.map());
+	const bool batched = vcc.is_upload_batch_open();
+	for (uint32_t first_slice = 0; first_slice < uint32_t(d); first_slice += slab_slice_count)
+	{
+		// the submission waits for the copy, so the staging buffer can be refilled afterwards
+		const uint32_t slice_count = std::min(slab_slice_count, d - first_slice);
+		load_slices(first_slice, slice_count, staging_data);
+		if (!vcc.is_upload_batch_open()) vcc.begin_upload_batch();
+		vk::CommandBuffer& cb = vcc.get_upload_buffer();
+		require(cb, vk::ImageLayout::eTransferDstOptimal, vk::PipelineStageFlagBits2::eTransfer, vk::AccessFlagBits2::eTransferWrite, {.aspect = vk::ImageAspectFlagBits::eColor, .base_mip_level = 0, .level_count = 1, .base_array_layer = 0, .layer_count = 1});
+		vk::BufferImageCopy copy_region{};
+		copy_region.imageSubresource = vk::ImageSubresourceLayers(vk::ImageAspectFlagBits::eColor, 0, 0, 1);
+		copy_region.imageOffset = vk::Offset3D(0, 0, first_slice);
+		copy_region.imageExtent = vk::Extent3D(w, h, slice_count);
+		cb.copyBufferToImage(buffer.get(), image, vk::ImageLayout::eTransferDstOptimal, copy_region);
+		vcc.submit_upload_batch();
+	}
+	buffer.unmap();
+	buffer.destruct();
+
+	// an upload batch that was open before is reopened, so that the mip map generation is part of it
+	vcc.begin_upload_batch();
+	vk::CommandBuffer& cb = vcc.get_upload_buffer();
+	if (usage_flags & vk::ImageUsageFlagBits::eSampled)
+	{
+		if (mip_levels > 1) generate_mipmaps(cb);
+		else require(cb, vk::ImageLayout::eShaderReadOnlyOptimal, vk::PipelineStageFlagBits2::eFragmentShader, vk::AccessFlagBits2::eShaderRead);
+	}
+	if (!batched) vcc.submit_upload_batch();
+	create_image_view(vk::ImageAspectFlagBits::eColor, vk::ImageViewType::e3D);
+	create_sampler(linear_filtering ? vk::Filter::eLinear : vk::Filter::eNearest);
+}
+
+bool Image::is_host_image_copy_usable(vk::ImageUsageFlags usage, vk::ImageLayout layout) const
+{
+	if (!vmc.logical_device.is_host_image_copy_supported() || !vmc.logical_device.is_host_image_copy_dst_layout(layout)) return false;
+	const vk::StructureChain<vk::FormatProperties2, vk::FormatProperties3> format_properties = vmc.physical_device.get().getFormatProperties2<vk::FormatProperties2, vk::FormatProperties3>(format);
+	if (!(format_properties.get<vk::FormatProperties3>().optimalTilingFeatures & vk::FormatFeatureFlagBits2::eHostImageTransfer)) return false;
+	// the host transfer usage may force a layout that is slower to access on the device, the staging path is used in that case
+	vk::PhysicalDeviceImageFormatInfo2 format_info(format, vk::ImageType::e2D, vk::ImageTiling::eOptimal, usage);
+	vk::HostImageCopyDevicePerformanceQuery performance_query;
+	vk::ImageFormatProperties2 image_format_properties;
+	image_format_properties.pNext = &performance_query;
+	if (vmc.physical_device.get().getImageFormatProperties2(&format_info, &image_format_properties) != vk::Result::eSuccess) return false;
+	return performance_query.optimalDeviceAccess;
 }
 
 void Image::create_image_view(vk::ImageAspectFlags aspects, vk::ImageViewType image_view_type)
@@ -337,38 +650,192 @@ void Image::create_sampler(vk::Filter filter, vk::SamplerAddressMode sampler_add
 	sci.mipLodBias = 0.0f;
 	sci.minLod = 0.0f;
 	sci.maxLod = mip_levels;
-	sampler = vmc.logical_device.get().createSampler(sci);
+	// samplers are shared between all images with the same sampler state
+	if (sampler) vmc.sampler_cache.release(sampler);
+	sampler = vmc.sampler_cache.acquire(sci);
 }
 
 void Image::destruct()
 {
-	vmc.logical_device.get().destroySampler(sampler);
+	if (sampler) vmc.sampler_cache.release(sampler);
+	for (const std::pair<ImageViewDesc, vk::ImageView>& cached_view : cached_views) vmc.logical_device.get().destroyImageView(cached_view.second);
+	cached_views.clear();
 	vmc.logical_device.get().destroyImageView(view);
-	vmaDestroyImage(vmc.va, VkImage(image), vmaa);
+	if (vmaa) vmaDestroyImage(vmc.va, VkImage(image), vmaa);
+	else vmc.logical_device.get().destroyImage(image);
 }
 
 void Image::transition_image_layout(VulkanCommandContext& vcc, vk::ImageLayout new_layout, vk::PipelineStageFlags2 src_stage_flags, vk::PipelineStageFlags2 dst_stage_flags, vk::AccessFlags2 src_access_flags, vk::AccessFlags2 dst_access_flags)
 {
 	// transition the image layout of this image
+	// the tracked state of each subresource provides its old layout, the given source scope covers accesses that were not recorded with require()
+	for (SubresourceState& state : subresource_states)
+	{
+		state.write_stage |= src_stage_flags;
+		state.write_access |= src_access_flags;
+	}
 	vk::CommandBuffer& cb = vcc.get_one_time_graphics_buffer();
-	perform_image_layout_transition(cb, {
-		.image = image,
-		.range = {
-			.aspect = default_aspect_for_format(format),
-			.base_mip_level = 0,
-			.level_count = mip_levels,
-			.base_array_layer = 0,
-			.layer_count = layer_count
-		},
-		.old_layout = layout,
-		.new_layout = new_layout,
-		.src_stage = src_stage_flags,
-		.src_access = src_access_flags,
-		.dst_stage = dst_stage_flags,
-		.dst_access = dst_access_flags
-	});
+	require(cb, new_layout, dst_stage_flags, dst_access_flags, get_full_range());
 	vcc.submit_graphics(cb, true);
-	layout = new_layout;
+	// the queue is idle after the submission, so nothing has to be waited for anymore
+	subresource_states.assign(subresource_states.size(), {.layout = new_layout});
+}
+
+// accesses that modify memory and therefore require a barrier before any other access
+constexpr vk::AccessFlags2 write_access_mask = vk::AccessFlagBits2::eShaderWrite | vk::AccessFlagBits2::eShaderStorageWrite | vk::AccessFlagBits2::eColorAttachmentWrite | vk::AccessFlagBits2::eDepthStencilAttachmentWrite | vk::AccessFlagBits2::eTransferWrite | vk::AccessFlagBits2::eHostWrite | vk::AccessFlagBits2::eMemoryWrite;
+
+void Image::require(vk::CommandBuffer& cb, vk::ImageLayout new_layout, vk::PipelineStageFlags2 stage, vk::AccessFlags2 access)
+{
+	require(cb, new_layout, stage, access, get_full_range());
+}
+
+void Image::require(vk::CommandBuffer& cb, vk::ImageLayout new_layout, vk::PipelineStageFlags2 stage, vk::AccessFlags2 access, const ImageSubresourceRangeDesc& range)
+{
+	std::vector<vk::ImageMemoryBarrier2> barriers;
+	require(barriers, new_layout, stage, access, range);
+	perform_image_barriers(cb, barriers);
+}
+
+void Image::require(std::vector<vk::ImageMemoryBarrier2>& barriers, vk::ImageLayout new_layout, vk::PipelineStageFlags2 stage, vk::AccessFlags2 access, const ImageSubresourceRangeDesc& range)
+{
+	VKTE_ASSERT(range.base_mip_level + range.level_count <= mip_levels && range.base_array_layer + range.layer_count <= layer_count, "vkte: Subresource range exceeds image!");
+	const bool writes = bool(access & write_access_mask);
+
+	// source scope of the barrier that one subresource needs, subresources with equal sources share one barrier
+	struct Source
+	{
+		bool required = false;
+		vk::ImageLayout layout = vk::ImageLayout::eUndefined;
+		vk::PipelineStageFlags2 stage = vk::PipelineStageFlagBits2::eNone;
+		vk::AccessFlags2 access = vk::AccessFlagBits2::eNone;
+		bool operator==(const Source& other) const = default;
+	};
+	// block of subresources with the same source, runs of mip levels are extended over consecutive layers
+	struct Block
+	{
+		Source source;
+		uint32_t base_mip_level;
+		uint32_t level_count;
+		uint32_t base_array_layer;
+		uint32_t layer_count;
+	};
+	std::vector<Block> blocks;
+	std::vector<Block> layer_runs;
+	for (uint32_t layer = range.base_array_layer; layer < range.base_array_layer + range.layer_count; ++layer)
+	{
+		layer_runs.clear();
+		for (uint32_t mip = range.base_mip_level; mip < range.base_mip_level + range.level_count; ++mip)
+		{
+			SubresourceState& state = subresource_states[layer * mip_levels + mip];
+			Source source;
+			if (state.layout != new_layout || writes)
+			{
+				// layout transitions and writes have to wait for the last write and all reads since then
+				source = {true, state.layout, state.write_stage | state.read_stages, state.write_access};
+				state.write_stage = stage;
+				state.write_access = access & write_access_mask;
+				state.read_stages = writes ? vk::PipelineStageFlagBits2::eNone : stage;
+				state.read_access = writes ? vk::AccessFlagBits2::eNone : access;
+				state.layout = new_layout;
+			}
+			else if ((stage & ~state.read_stages) || (access & ~state.read_access))
+			{
+				// reads only have to wait for the last write, reads that already waited for it need no barrier
+				if (state.write_stage || state.write_access) source = {true, state.layout, state.write_stage, state.write_access};
+				state.read_stages |= stage;
+				state.read_access |= access;
+			}
+			if (!layer_runs.empty() && layer_runs.back().source == source) layer_runs.back().level_count++;
+			else layer_runs.push_back({source, mip, 1, layer, 1});
+		}
+		for (const Block& run : layer_runs)
+		{
+			if (!run.source.required) continue;
+			auto block = std::find_if(blocks.begin(), blocks.end(), [&](const Block& b) { return b.source == run.source && b.base_mip_level == run.base_mip_level && b.level_count == run.level_count && b.base_array_layer + b.layer_count == layer; });
+			if (block != blocks.end()) block->layer_count++;
+			else blocks.push_back(run);
+		}
+	}
+
+	for (const Block& block : blocks)
+	{
+		vk::ImageMemoryBarrier2 b;
+		b.srcStageMask = block.source.stage;
+		b.srcAccessMask = block.source.access;
+		b.dstStageMask = stage;
+		b.dstAccessMask = access;
+		b.oldLayout = block.source.layout;
+		b.newLayout = new_layout;
+		b.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		b.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		b.image = image;
+		b.subresourceRange.aspectMask = range.aspect;
+		b.subresourceRange.baseMipLevel = block.base_mip_level;
+		b.subresourceRange.levelCount = block.level_count;
+		b.subresourceRange.baseArrayLayer = block.base_array_layer;
+		b.subresourceRange.layerCount = block.layer_count;
+		barriers.push_back(b);
+	}
+}
+
+ReadbackHandle Image::read_async(vk::CommandBuffer& cb, ReadbackRing& ring, vk::Fence fence)
+{
+	auto [buffer, handle] = ring.acquire(get_readback_byte_size(), fence);
+	record_readback(cb, buffer);
+	return handle;
+}
+
+ReadbackHandle Image::read_async(vk::CommandBuffer& cb, ReadbackRing& ring, vk::Semaphore timeline, uint64_t timeline_value)
+{
+	auto [buffer, handle] = ring.acquire(get_readback_byte_size(), timeline, timeline_value);
+	record_readback(cb, buffer);
+	return handle;
+}
+
+vk::DeviceSize Image::get_readback_byte_size() const
+{
+	// only the depth aspect is read for depth stencil formats and its texels are laid out differently than in the image
+	const vk::ImageAspectFlags aspect = default_aspect_for_format(format);
+	if (aspect & vk::ImageAspectFlagBits::eDepth) return vk::DeviceSize(w) * h * get_aspect_texel_byte_size(format, vk::ImageAspectFlagBits::eDepth) * layer_count;
+	if (aspect & vk::ImageAspectFlagBits::eStencil) return vk::DeviceSize(w) * h * layer_count;
+	return get_image_byte_size(format, w, h, d) * layer_count;
+}
+
+void Image::record_readback(vk::CommandBuffer& cb, vk::Buffer buffer)
+{
+	// without separate depth stencil layouts both aspects are transitioned, but only one aspect can be copied at once and the depth aspect is read
+	const vk::ImageAspectFlags transition_aspect = default_aspect_for_format(format);
+	require(cb, vk::ImageLayout::eTransferSrcOptimal, vk::PipelineStageFlagBits2::eTransfer, vk::AccessFlagBits2::eTransferRead, {.aspect = transition_aspect, .base_mip_level = 0, .level_count = 1, .base_array_layer = 0, .layer_count = layer_count});
+	vk::ImageAspectFlags aspect = transition_aspect;
+	if (aspect & vk::ImageAspectFlagBits::eDepth) aspect = vk::ImageAspectFlagBits::eDepth;
+
+	vk::BufferImageCopy copy_region{};
+	copy_region.bufferOffset = 0;
+	copy_region.bufferRowLength = 0;
+	copy_region.bufferImageHeight = 0;
+	copy_region.imageSubresource.aspectMask = aspect;
+	copy_region.imageSubresource.mipLevel = 0;
+	copy_region.imageSubresource.baseArrayLayer = 0;
+	copy_region.imageSubresource.layerCount = layer_count;
+	copy_region.imageOffset = vk::Offset3D{0, 0, 0};
+	copy_region.imageExtent = vk::Extent3D(w, h, d);
+	cb.copyImageToBuffer(image, vk::ImageLayout::eTransferSrcOptimal, buffer, copy_region);
+
+	// make the copied data visible to the host
+	vk::BufferMemoryBarrier2 bmb;
+	bmb.srcStageMask = vk::PipelineStageFlagBits2::eTransfer;
+	bmb.srcAccessMask = vk::AccessFlagBits2::eTransferWrite;
+	bmb.dstStageMask = vk::PipelineStageFlagBits2::eHost;
+	bmb.dstAccessMask = vk::AccessFlagBits2::eHostRead;
+	bmb.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	bmb.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	bmb.buffer = buffer;
+	bmb.offset = 0;
+	bmb.size = VK_WHOLE_SIZE;
+	vk::DependencyInfo dep;
+	dep.bufferMemoryBarrierCount = 1;
+	dep.pBufferMemoryBarriers = &bmb;
+	cb.pipelineBarrier2(dep);
 }
 
 VmaAllocation Image::get_allocation() const
@@ -393,9 +860,30 @@ uint32_t Image::get_layer_count() const
 	return layer_count;
 }
 
+vk::Extent3D Image::get_extent() const
+{
+	return vk::Extent3D(w, h, d);
+}
+
 vk::ImageLayout Image::get_layout() const
 {
-	return layout;
+	return subresource_states[0].layout;
+}
+
+vk::ImageLayout Image::get_layout(uint32_t mip_level, uint32_t array_layer) const
+{
+	return subresource_states[array_layer * mip_levels + mip_level].layout;
+}
+
+ImageSubresourceRangeDesc Image::get_full_range() const
+{
+	return ImageSubresourceRangeDesc{
+		.aspect = default_aspect_for_format(format),
+		.base_mip_level = 0,
+		.level_count = mip_levels,
+		.base_array_layer = 0,
+		.layer_count = layer_count
+	};
 }
 
 vk::Image& Image::get_image()
@@ -408,54 +896,58 @@ vk::ImageView Image::get_view() const
 	return view;
 }
 
+vk::ImageView Image::get_view(const ImageViewDesc& desc)
+{
+	// images only have a handful of views, so a linear search is cheaper than hashing the description
+	for (const std::pair<ImageViewDesc, vk::ImageView>& cached_view : cached_views)
+	{
+		if (cached_view.first == desc) return cached_view.second;
+	}
+	VKTE_ASSERT(desc.range.base_mip_level + desc.range.level_count <= mip_levels && desc.range.base_array_layer + desc.range.layer_count <= layer_count, "vkte: Image view range exceeds image!");
+	vk::ImageViewCreateInfo ivci;
+	ivci.image = image;
+	ivci.viewType = desc.type;
+	ivci.format = desc.format == vk::Format::eUndefined ? format : desc.format;
+	ivci.subresourceRange.aspectMask = desc.range.aspect;
+	ivci.subresourceRange.baseMipLevel = desc.range.base_mip_level;
+	ivci.subresourceRange.levelCount = desc.range.level_count;
+	ivci.subresourceRange.baseArrayLayer = desc.range.base_array_layer;
+	ivci.subresourceRange.layerCount = desc.range.layer_count;
+	vk::ImageView new_view = vmc.logical_device.get().createImageView(ivci);
+	cached_views.emplace_back(desc, new_view);
+	return new_view;
+}
+
 vk::Sampler Image::get_sampler() const
 {
 	return sampler;
 }
 
-void Image::generate_mipmaps(VulkanCommandContext& vcc)
+void Image::generate_mipmaps(vk::CommandBuffer& cb)
 {
-	vk::CommandBuffer& cb = vcc.get_one_time_graphics_buffer();
-	vk::ImageMemoryBarrier imb;
-	imb.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-	imb.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-	imb.image = image;
-	imb.subresourceRange.aspectMask = vk::ImageAspectFlagBits::eColor;
-	imb.subresourceRange.levelCount = 1;
-	imb.subresourceRange.baseArrayLayer = 0;
-	imb.subresourceRange.layerCount = layer_count;
-
+	auto mip_range = [&](uint32_t mip_level) -> ImageSubresourceRangeDesc {
+		return {.aspect = vk::ImageAspectFlagBits::eColor, .base_mip_level = mip_level, .level_count = 1, .base_array_layer = 0, .layer_count = layer_count};
+	};
+	std::vector<vk::ImageMemoryBarrier2> barriers;
 	uint32_t mip_w = w;
 	uint32_t mip_h = h;
+	uint32_t mip_d = d;
 	for (uint32_t i = 1; i < mip_levels; ++i)
 	{
-		imb.subresourceRange.baseMipLevel = i - 1;
-		imb.oldLayout = vk::ImageLayout::eTransferDstOptimal;
-		imb.newLayout = vk::ImageLayout::eTransferSrcOptimal;
-		imb.srcAccessMask = vk::AccessFlagBits::eTransferWrite;
-		imb.dstAccessMask = vk::AccessFlagBits::eTransferRead;
-		cb.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eTransfer, {}, nullptr, nullptr, imb);
+		// read from the previous level and write to the current one, both barriers are recorded together
+		barriers.clear();
+		require(barriers, vk::ImageLayout::eTransferSrcOptimal, vk::PipelineStageFlagBits2::eTransfer, vk::AccessFlagBits2::eTransferRead, mip_range(i - 1));
+		require(barriers, vk::ImageLayout::eTransferDstOptimal, vk::PipelineStageFlagBits2::eTransfer, vk::AccessFlagBits2::eTransferWrite, mip_range(i));
+		perform_image_barriers(cb, barriers);
 
-		blit_image(cb, image, i - 1, {int32_t(mip_w), int32_t(mip_h), 1}, image, i, {int32_t(mip_w > 1 ? mip_w / 2 : 1), int32_t(mip_h > 1 ? mip_h / 2 : 1), 1}, layer_count);
+		blit_image(cb, image, i - 1, {int32_t(mip_w), int32_t(mip_h), int32_t(mip_d)}, image, i, {int32_t(mip_w > 1 ? mip_w / 2 : 1), int32_t(mip_h > 1 ? mip_h / 2 : 1), int32_t(mip_d > 1 ? mip_d / 2 : 1)}, layer_count);
 
-		imb.oldLayout = vk::ImageLayout::eTransferSrcOptimal;
-		imb.newLayout = vk::ImageLayout::eShaderReadOnlyOptimal;
-		imb.srcAccessMask = vk::AccessFlagBits::eTransferRead;
-		imb.dstAccessMask = vk::AccessFlagBits::eShaderRead;
-		cb.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eFragmentShader, {}, nullptr, nullptr, imb);
+		require(cb, vk::ImageLayout::eShaderReadOnlyOptimal, vk::PipelineStageFlagBits2::eFragmentShader, vk::AccessFlagBits2::eShaderRead, mip_range(i - 1));
 
 		if (mip_w > 1) mip_w /= 2;
 		if (mip_h > 1) mip_h /= 2;
+		if (mip_d > 1) mip_d /= 2;
 	}
-
-	imb.subresourceRange.baseMipLevel = mip_levels - 1;
-	imb.oldLayout = vk::ImageLayout::eTransferDstOptimal;
-	imb.newLayout = vk::ImageLayout::eShaderReadOnlyOptimal;
-	layout = imb.newLayout;
-	imb.srcAccessMask = vk::AccessFlagBits::eTransferWrite;
-	imb.dstAccessMask = vk::AccessFlagBits::eShaderRead;
-	cb.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eFragmentShader, {}, nullptr, nullptr, imb);
-
-	vcc.submit_graphics(cb, true);
+	require(cb, vk::ImageLayout::eShaderReadOnlyOptimal, vk::PipelineStageFlagBits2::eFragmentShader, vk::AccessFlagBits2::eShaderRead, mip_range(mip_levels - 1));
 }
 } // namespace vkte
@@ -1,13 +1,22 @@
 #include "vkte/logical_device.hpp"
 
+#include <algorithm>
+#include <cstring>
 #include "vkte/physical_device.hpp"
+#include "vkte/vkte_log.hpp"
 
 namespace vkte
 {
 void LogicalDevice::construct(const PhysicalDevice& p_device, const Features& features, const QueueFamilies& queue_families, std::unordered_map<QueueIndex, vk::Queue>& queues)
 {
 	std::vector<vk::DeviceQueueCreateInfo> qci_s;
-	std::vector<uint32_t> queue_indices = queue_families.get(QueueFamilyFlags::Graphics | QueueFamilyFlags::Compute | QueueFamilyFlags::Transfer | QueueFamilyFlags::Present);
+	Queues requested_queues = QueueFamilyFlags::Graphics | QueueFamilyFlags::Compute | QueueFamilyFlags::Transfer | QueueFamilyFlags::Present;
+	if (features.sparse_residency)
+	{
+		VKTE_ASSERT(queue_families.get(QueueFamilyFlags::SparseBinding) != -1, "vkte: No queue family supports sparse binding!");
+		requested_queues |= QueueFamilyFlags::SparseBinding;
+	}
+	std::vector<uint32_t> queue_indices = queue_families.get(requested_queues);
 	float queue_prio = 1.0f;
 	for (uint32_t queue_family : queue_indices)
 	{
@@ -18,7 +27,21 @@ void LogicalDevice::construct(const PhysicalDevice& p_device, const Features& fe
 		qci_s.push_back(qci);
 	}
 
+	std::vector<const char*> extensions = p_device.get_extensions();
+	host_image_copy = detect_host_image_copy(p_device, extensions);
+	vk::PhysicalDeviceHostImageCopyFeatures host_image_copy_features;
+	host_image_copy_features.hostImageCopy = host_image_copy ? VK_TRUE : VK_FALSE;
+
+	vk::PhysicalDeviceShaderObjectFeaturesEXT shader_object_features;
+	shader_object_features.pNext = &host_image_copy_features;
+	shader_object_features.shaderObject = features.shader_object ? VK_TRUE : VK_FALSE;
+
+	vk::PhysicalDeviceGraphicsPipelineLibraryFeaturesEXT gpl_features;
+	gpl_features.pNext = &shader_object_features;
+	gpl_features.graphicsPipelineLibrary = features.graphics_pipeline_library ? VK_TRUE : VK_FALSE;
+
 	vk::PhysicalDeviceExtendedDynamicState3FeaturesEXT dynamic_state_3;
+	dynamic_state_3.pNext = &gpl_features;
 	dynamic_state_3.extendedDynamicState3PolygonMode = features.dynamic_polygon_mode ? VK_TRUE : VK_FALSE;
 
 	vk::PhysicalDeviceRayQueryFeaturesKHR rq_features;
@@ -40,6 +63,7 @@ void LogicalDevice::construct(const PhysicalDevice& p_device, const Features& fe
 	device_features_12.descriptorBindingPartiallyBound = VK_TRUE;
 	device_features_12.shaderSampledImageArrayNonUniformIndexing = VK_TRUE;
 	device_features_12.runtimeDescriptorArray = VK_TRUE;
+	device_features_12.timelineSemaphore = VK_TRUE;
 
 	vk::PhysicalDeviceVulkan13Features device_features_13;
 	device_features_13.pNext = &device_features_12;
@@ -53,6 +77,8 @@ void LogicalDevice::construct(const PhysicalDevice& p_device, const Features& fe
 	core_device_features.fillModeNonSolid = VK_TRUE;
 	core_device_features.fragmentStoresAndAtomics = VK_TRUE;
 	core_device_features.wideLines = VK_TRUE;
+	core_device_features.sparseBinding = features.sparse_residency ? VK_TRUE : VK_FALSE;
+	core_device_features.sparseResidencyImage2D = features.sparse_residency ? VK_TRUE : VK_FALSE;
 
 	vk::PhysicalDeviceFeatures2 device_features;
 	device_features.pNext = &device_features_13;
@@ -62,8 +88,8 @@ void LogicalDevice::construct(const PhysicalDevice& p_device, const Features& fe
 	dci.pNext = &device_features;
 	dci.queueCreateInfoCount = qci_s.size();
 	dci.pQueueCreateInfos = qci_s.data();
-	dci.enabledExtensionCount = p_device.get_extensions().size();
-	dci.ppEnabledExtensionNames = p_device.get_extensions().data();
+	dci.enabledExtensionCount = extensions.size();
+	dci.ppEnabledExtensionNames = extensions.data();
 
 	device = p_device.get().createDevice(dci);
 	std::unordered_map<uint32_t, std::string> queue_names;
@@ -92,6 +118,13 @@ void LogicalDevice::construct(const PhysicalDevice& p_device, const Features& fe
 		if (queue_names.contains(idx)) queue_names.at(idx) += ", present";
 		else queue_names.emplace(idx, "present");
 	}
+	if (features.sparse_residency)
+	{
+		uint32_t idx = queue_families.get(QueueFamilyFlags::SparseBinding);
+		queues.emplace(QueueIndex::SparseBinding, device.getQueue(idx, 0));
+		if (queue_names.contains(idx)) queue_names.at(idx) += ", sparse binding";
+		else queue_names.emplace(idx, "sparse binding");
+	}
 	for (const std::pair<uint32_t, std::string>& queue_name : queue_names)
 	{
 		vk::DebugUtilsObjectNameInfoEXT duoni(vk::Queue::objectType, uint64_t(static_cast<vk::Queue::CType>(device.getQueue(queue_name.first, 0))), queue_name.second.c_str());
@@ -99,6 +132,35 @@ void LogicalDevice::construct(const PhysicalDevice& p_device, const Features& fe
 	}
 }
 
+bool LogicalDevice::detect_host_image_copy(const PhysicalDevice& p_device, std::vector<const char*>& extensions)
+{
+	// the feature struct may only be queried if the device knows it
+	const bool is_core = p_device.get().getProperties().apiVersion >= VK_API_VERSION_1_4;
+	if (!is_core)
+	{
+		const std::vector<vk::ExtensionProperties> available_extensions = p_device.get().enumerateDeviceExtensionProperties();
+		if (std::none_of(available_extensions.begin(), available_extensions.end(), [](const vk::ExtensionProperties& e) { return strcmp(e.extensionName, VK_EXT_HOST_IMAGE_COPY_EXTENSION_NAME) == 0; })) return false;
+	}
+	vk::PhysicalDeviceHostImageCopyFeatures host_image_copy_features;
+	vk::PhysicalDeviceFeatures2 features;
+	features.pNext = &host_image_copy_features;
+	p_device.get().getFeatures2(&features);
+	if (!host_image_copy_features.hostImageCopy) return false;
+
+	vk::PhysicalDeviceHostImageCopyProperties host_image_copy_properties;
+	vk::PhysicalDeviceProperties2 properties;
+	properties.pNext = &host_image_copy_properties;
+	p_device.get().getProperties2(&properties);
+	host_image_copy_dst_layouts.resize(host_image_copy_properties.copyDstLayoutCount);
+	host_image_copy_properties.pCopyDstLayouts = host_image_copy_dst_layouts.data();
+	p_device.get().getProperties2(&properties);
+	host_image_copy_dst_layouts.resize(host_image_copy_properties.copyDstLayoutCount);
+
+	if (!is_core) extensions.push_back(VK_EXT_HOST_IMAGE_COPY_EXTENSION_NAME);
+	VKTE_INFO("vkte: Host image copy is supported");
+	return true;
+}
+
 void LogicalDevice::destruct()
 {
 	device.destroy();
@@ -108,4 +170,14 @@ const vk::Device& LogicalDevice::get() const
 {
 	return device;
 }
+
+bool LogicalDevice::is_host_image_copy_supported() const
+{
+	return host_image_copy;
+}
+
+bool LogicalDevice::is_host_image_copy_dst_layout(vk::ImageLayout layout) const
+{
+	return std::find(host_image_copy_dst_layouts.begin(), host_image_copy_dst_layouts.end(), layout) != host_image_copy_dst_layouts.end();
+}
 } // namespace vkte
@@ -1,10 +1,12 @@
 #include "vkte/pipeline.hpp"
 
+#include <algorithm>
 #include <fstream>
 #include <filesystem>
 #include <iostream>
 #include "vkte/image.hpp"
-#include "vkte/vkte_log.hpp"
+#include "vkte/shader_compiler.hpp"
+#include "vkte/spirv_reflection.hpp"
 #include "vkte/vkte_log.hpp"
 
 namespace vkte
@@ -15,6 +17,11 @@ Pipeline::Pipeline(const VulkanMainContext& vmc, Pipeline::Type type) : vmc(vmc)
 	else if (type == Type::Compute) compute_settings = std::make_unique<ComputeSettings>();
 }
 
+Pipeline::Type Pipeline::get_type() const
+{
+	return type;
+}
+
 Pipeline::GraphicsSettings& Pipeline::get_graphics_settings()
 {
 	VKTE_ASSERT(type == Type::Graphics, "vkte: Invalid access to graphics pipeline settings!");
@@ -27,299 +34,777 @@ Pipeline::ComputeSettings& Pipeline::get_compute_settings()
 	return *compute_settings;
 }
 
-std::string get_slang_stage(vk::ShaderStageFlagBits stage_flag)
-{
-	if (stage_flag & vk::ShaderStageFlagBits::eVertex) return "vertex";
-	if (stage_flag & vk::ShaderStageFlagBits::eTessellationControl) return "tesscontrol";
-	if (stage_flag & vk::ShaderStageFlagBits::eTessellationEvaluation) return "tesseval";
-	if (stage_flag & vk::ShaderStageFlagBits::eGeometry) return "geometry";
-	if (stage_flag & vk::ShaderStageFlagBits::eFragment) return "fragment";
-	if (stage_flag & vk::ShaderStageFlagBits::eCompute) return "compute";
-	// Ray tracing stages
-	if (stage_flag & vk::ShaderStageFlagBits::eRaygenKHR) return "raygeneration";
-	if (stage_flag & vk::ShaderStageFlagBits::eIntersectionKHR) return "intersection";
-	if (stage_flag & vk::ShaderStageFlagBits::eAnyHitKHR) return "anyhit";
-	if (stage_flag & vk::ShaderStageFlagBits::eClosestHitKHR) return "closesthit";
-	if (stage_flag & vk::ShaderStageFlagBits::eMissKHR) return "miss";
-	if (stage_flag & vk::ShaderStageFlagBits::eCallableKHR) return "callable";
-	// Mesh shading stages (EXT/NV aliases)
-#ifdef VK_EXT_mesh_shader
-	if (stage_flag & vk::ShaderStageFlagBits::eTaskEXT) return "task";
-	if (stage_flag & vk::ShaderStageFlagBits::eMeshEXT) return "mesh";
-#endif
-#ifdef VK_NV_mesh_shader
-	if (stage_flag & vk::ShaderStageFlagBits::eTaskNV) return "task";
-	if (stage_flag & vk::ShaderStageFlagBits::eMeshNV) return "mesh";
-#endif
-	VKTE_ASSERT(false, "vkte: Unsupported slang shader stage flag");
-	return "";
-}
-
-bool is_command_available(const std::string& command)
-{
-#if defined(WIN32) || defined(_WIN32) || defined(__WIN32__) || defined(__NT__)
-	std::string check = "where " + command + " >nul 2>nul";
-#else
-	std::string check = "command -v " + command + " >/dev/null 2>&1";
-#endif
-	return std::system(check.c_str()) == 0;
-}
-
-bool compile_shader(const vk::Device& device, const std::string& shader_root_dir, const Shader& shader, vk::PipelineShaderStageCreateInfo& pssci, vk::SpecializationInfo& spec_info)
-{
-	std::filesystem::path shader_dir(shader_root_dir);
-	std::filesystem::path shader_bin_dir(shader_dir / "bin/");
-	if (!std::filesystem::exists(shader_bin_dir)) std::filesystem::create_directory(shader_bin_dir);
-	std::filesystem::path shader_file(shader_dir / shader.name);
-	std::filesystem::path shader_bin_file(shader_bin_dir / (shader.name + ".spv"));
-	std::string command;
-	std::string args;
-	if (shader.lang == Language::Glsl)
+// if spirv is given, the code is kept for shader objects instead of acquiring a shader module
+bool create_shader_stage(ShaderModuleCache& shader_module_cache, const ShaderCompileResult& result, const Shader& shader, vk::PipelineShaderStageCreateInfo& pssci, vk::SpecializationInfo& spec_info, uint64_t& spirv_hash, std::string* spirv)
+{
+	if (!result.success) return false;
+	if (spirv)
 	{
-		command = "glslc";
-		args = std::format("--target-env=vulkan1.4 -O -o {0} {1}", shader_bin_file.string(), shader_file.string());
+		std::ifstream file(result.spirv_path, std::ios::binary);
+		VKTE_ASSERT(file.is_open(), "vkte: Failed to open shader file \"" + shader.name + "\"");
+		spirv->resize(std::filesystem::file_size(result.spirv_path));
+		file.read(spirv->data(), spirv->size());
+		spirv_hash = hash_bytes(spirv->data(), spirv->size());
 	}
-	else if (shader.lang == Language::Slang)
+	// pipelines that use the same SPIR-V share the module
+	else pssci.module = shader_module_cache.acquire(result.spirv_path, spirv_hash);
+	pssci.stage = shader.stage_flag;
+	pssci.pName = "main";
+
+	spec_info = vk::SpecializationInfo(shader.get_spec_entries().size(), shader.get_spec_entries().data(), sizeof(uint32_t) * shader.get_spec_entries_data().size(), shader.get_spec_entries_data().data());
+	pssci.pSpecializationInfo = &spec_info;
+	return true;
+}
+
+std::span<const Shader> Pipeline::get_shaders() const
+{
+	if (type == Type::Graphics) return graphics_settings->shaders;
+	return {&compute_settings->shader, 1};
+}
+
+bool Pipeline::compile_shaders(uint32_t job_count)
+{
+	return compile_shaders({this}, job_count);
+}
+
+bool Pipeline::compile_shaders(const std::vector<Pipeline*>& pipelines, uint32_t job_count)
+{
+	if (pipelines.empty()) return true;
+	// the shaders of all pipelines are compiled in one batch, so that the stages of different pipelines are compiled in parallel too
+	std::vector<Shader> shaders;
+	for (const Pipeline* pipeline : pipelines)
 	{
-		command = "slangc";
-		std::string stage = get_slang_stage(shader.stage_flag);
-		// enable all capabilities to prevent any warnings about implicit upgrades
-		args = std::format("-target spirv -emit-spirv-directly -profile spirv_1_5+all -fvk-use-scalar-layout -matrix-layout-column-major -entry main -stage {2} -o {0} {1}", shader_bin_file.string(), shader_file.string(), stage);
+		const std::span<const Shader> pipeline_shaders = pipeline->get_shaders();
+		shaders.insert(shaders.end(), pipeline_shaders.begin(), pipeline_shaders.end());
 	}
-#if defined(WIN32) || defined(_WIN32) || defined(__WIN32__) || defined(__NT__)
-	command += ".exe";
-#elif __linux__
-#endif
-	if (is_command_available(command))
+	const std::vector<ShaderCompileResult> results = vkte::compile_shaders(pipelines[0]->vmc.shader_root_dir, shaders, job_count);
+	bool success = true;
+	auto result = results.begin();
+	for (Pipeline* pipeline : pipelines)
 	{
-		VKTE_ASSERT(std::filesystem::exists(shader_file), "vkte: Failed to find shader file \"" + shader.name + "\"");
-		if (std::filesystem::exists(shader_bin_file)) std::filesystem::remove(shader_bin_file);
-		system((command + " " + args).c_str());
-		if (!std::filesystem::exists(shader_bin_file)) return false;
+		const std::size_t shader_count = pipeline->get_shaders().size();
+		success &= pipeline->create_shader_stages({result, result + shader_count});
+		result += shader_count;
 	}
-	else
+	return success;
+}
+
+bool Pipeline::create_shader_stages(std::span<const ShaderCompileResult> results)
+{
+	for (vk::PipelineShaderStageCreateInfo& pssci : shader_stages) vmc.shader_module_cache.release(pssci.module);
+	shader_stages.clear();
+	spec_infos.clear();
+	// the specialization infos point into the shaders of the settings, so they must not be copied
+	const std::span<const Shader> shaders = get_shaders();
+	shader_stages.resize(shaders.size());
+	spec_infos.resize(shaders.size());
+	spirv_hashes.resize(shaders.size());
+	spirv_codes.clear();
+	if (use_shader_objects()) spirv_codes.resize(shaders.size());
+	for (uint32_t i = 0; i < shaders.size(); i++)
 	{
-		if (!std::filesystem::exists(shader_bin_file))
+		if (!create_shader_stage(vmc.shader_module_cache, results[i], shaders[i], shader_stages[i], spec_infos[i], spirv_hashes[i], spirv_codes.empty() ? nullptr : &spirv_codes[i]))
 		{
-			VKTE_ERROR("vkte: Compiler \"{}\" not available and no cached SPIR-V found for shader \"{}\"", command, shader.name);
+			// stages that were created before the failure are destroyed with the next compilation or destruct()
+			shader_stages.resize(i);
 			return false;
 		}
-		VKTE_WARN("vkte: Compiler \"{}\" not available, using cached SPIR-V for shader \"{}\"", command, shader.name);
 	}
-	std::ifstream file(shader_bin_file.string(), std::ios::binary);
-	VKTE_ASSERT(file.is_open(), "vkte: Failed to open shader file \"" + shader.name + "\"");
-	std::ostringstream file_stream;
-	file_stream << file.rdbuf();
-	std::string source = file_stream.str();
-
-	vk::ShaderModuleCreateInfo smci;
-	smci.codeSize = source.size();
-	smci.pCode = reinterpret_cast<const uint32_t*>(source.c_str());
-	pssci.module = device.createShaderModule(smci);
-	pssci.stage = shader.stage_flag;
-	pssci.pName = "main";
+	if (needs_reflection())
+	{
+		std::vector<ShaderReflection> stage_reflections;
+		for (uint32_t i = 0; i < shaders.size(); i++) stage_reflections.push_back(reflect_spirv_file(results[i].spirv_path, shaders[i].stage_flag));
+		reflection = merge_reflections(stage_reflections);
+	}
+	return true;
+}
 
-	spec_info = vk::SpecializationInfo(shader.get_spec_entries().size(), shader.get_spec_entries().data(), sizeof(uint32_t) * shader.get_spec_entries_data().size(), shader.get_spec_entries_data().data());
-	pssci.pSpecializationInfo = &spec_info;
+bool Pipeline::needs_reflection() const
+{
+	// the local size of compute shaders is always reflected
+	if (type == Type::Graphics) return graphics_settings->set_layout == nullptr;
 	return true;
 }
 
-bool Pipeline::compile_shaders()
+void Pipeline::create_pipeline_layout(const vk::DescriptorSetLayout* set_layout, const std::vector<vk::PushConstantRange>& pcrs)
 {
-	for (vk::PipelineShaderStageCreateInfo& pssci : shader_stages) vmc.logical_device.get().destroyShaderModule(pssci.module);
-	shader_stages.clear();
-	spec_infos.clear();
+	reflected_layout = set_layout == nullptr;
+	if (reflected_layout)
+	{
+		// sets without bindings in between get an empty layout, identical layouts are shared with other pipelines and descriptor set handlers
+		for (uint32_t i = 0; i < reflection.get_set_count(); ++i) set_layouts.push_back(vmc.descriptor_set_layout_cache.acquire(reflection.get_layout_bindings(i)));
+		push_constant_ranges = reflection.push_constant_ranges;
+	}
+	else
+	{
+		set_layouts = {*set_layout};
+		push_constant_ranges = pcrs;
+	}
+	vk::PipelineLayoutCreateInfo plci;
+	plci.setSetLayouts(set_layouts);
+	plci.setPushConstantRanges(push_constant_ranges);
+	pipeline_layout = vmc.logical_device.get().createPipelineLayout(plci);
+}
+
+// the create infos point into the state, so it must not be moved
+struct Pipeline::GraphicsState
+{
+	std::vector<vk::DynamicState> dynamic_states;
+	vk::PipelineDynamicStateCreateInfo pdsci;
+	vk::PipelineVertexInputStateCreateInfo pvisci;
+	vk::PipelineInputAssemblyStateCreateInfo piasci;
+	vk::PipelineViewportStateCreateInfo pvsci;
+	vk::PipelineRasterizationStateCreateInfo prsci;
+	vk::PipelineMultisampleStateCreateInfo pmssci;
+	std::vector<vk::PipelineColorBlendAttachmentState> pcbas;
+	vk::PipelineColorBlendStateCreateInfo pcbsci;
+	vk::PipelineDepthStencilStateCreateInfo pdssci;
+	vk::PipelineRenderingCreateInfo prci;
+	vk::GraphicsPipelineCreateInfo gpci;
+};
+
+std::vector<vk::PipelineColorBlendAttachmentState> Pipeline::get_blend_states() const
+{
+	const GraphicsSettings& gs = *graphics_settings;
+	if (!gs.blend_states.empty())
+	{
+		VKTE_ASSERT(gs.blend_states.size() == gs.color_formats.size(), "vkte: Number of blend states does not match the number of color attachments!");
+		return gs.blend_states;
+	}
+	vk::PipelineColorBlendAttachmentState pcbas;
+	pcbas.colorWriteMask = vk::ColorComponentFlagBits::eR | vk::ColorComponentFlagBits::eG | vk::ColorComponentFlagBits::eB | vk::ColorComponentFlagBits::eA;
+	if (gs.additive_blending)
+	{
+		pcbas.blendEnable = VK_TRUE;
+		pcbas.srcColorBlendFactor = vk::BlendFactor::eSrcAlpha;
+		pcbas.dstColorBlendFactor = vk::BlendFactor::eOne;
+	}
+	else
+	{
+		pcbas.blendEnable = VK_FALSE;
+		pcbas.srcColorBlendFactor = vk::BlendFactor::eOne;
+		pcbas.dstColorBlendFactor = vk::BlendFactor::eZero;
+	}
+	pcbas.colorBlendOp = vk::BlendOp::eAdd;
+	pcbas.srcAlphaBlendFactor = vk::BlendFactor::eOne;
+	pcbas.dstAlphaBlendFactor = vk::BlendFactor::eZero;
+	pcbas.alphaBlendOp = vk::BlendOp::eAdd;
+	return std::vector<vk::PipelineColorBlendAttachmentState>(gs.color_formats.size(), pcbas);
+}
+
+void Pipeline::fill_graphics_state(GraphicsState& state) const
+{
+	state.dynamic_states = {vk::DynamicState::eViewport, vk::DynamicState::eScissor};
+	if (vmc.get_features().device_features.dynamic_polygon_mode) state.dynamic_states.push_back(vk::DynamicState::ePolygonModeEXT);
+	state.pdsci.dynamicStateCount = state.dynamic_states.size();
+	state.pdsci.pDynamicStates = state.dynamic_states.data();
+
+	state.pvisci.vertexBindingDescriptionCount = graphics_settings->binding_descriptions.size();
+	state.pvisci.pVertexBindingDescriptions = graphics_settings->binding_descriptions.data();
+	state.pvisci.vertexAttributeDescriptionCount = graphics_settings->attribute_description.size();
+	state.pvisci.pVertexAttributeDescriptions = graphics_settings->attribute_description.data();
+
+	state.piasci.topology = graphics_settings->primitive_topology;
+	state.piasci.primitiveRestartEnable = VK_FALSE;
+
+	state.pvsci.viewportCount = 1;
+	state.pvsci.scissorCount = 1;
+
+	state.prsci.depthClampEnable = VK_FALSE;
+	state.prsci.rasterizerDiscardEnable = VK_FALSE;
+	state.prsci.polygonMode = graphics_settings->polygon_mode;
+	state.prsci.lineWidth = 0.5f;
+	state.prsci.cullMode = graphics_settings->cull_mode;
+	state.prsci.frontFace = graphics_settings->front_face;
+	state.prsci.depthBiasEnable = graphics_settings->depth_bias ? VK_TRUE : VK_FALSE;
+	state.prsci.depthBiasConstantFactor = graphics_settings->depth_bias_constant_factor;
+	state.prsci.depthBiasClamp = graphics_settings->depth_bias_clamp;
+	state.prsci.depthBiasSlopeFactor = graphics_settings->depth_bias_slope_factor;
+
+	state.pmssci.sampleShadingEnable = graphics_settings->min_sample_shading > 0.0f ? VK_TRUE : VK_FALSE;
+	state.pmssci.rasterizationSamples = graphics_settings->sample_count;
+	state.pmssci.minSampleShading = graphics_settings->min_sample_shading;
+	state.pmssci.pSampleMask = nullptr;
+	state.pmssci.alphaToCoverageEnable = VK_FALSE;
+	state.pmssci.alphaToOneEnable = VK_FALSE;
+
+	state.pcbas = get_blend_states();
+
+	state.pcbsci.logicOpEnable = VK_FALSE;
+	state.pcbsci.logicOp = vk::LogicOp::eCopy;
+	state.pcbsci.attachmentCount = state.pcbas.size();
+	state.pcbsci.pAttachments = state.pcbas.data();
+	state.pcbsci.blendConstants[0] = 0.0f;
+	state.pcbsci.blendConstants[1] = 0.0f;
+	state.pcbsci.blendConstants[2] = 0.0f;
+	state.pcbsci.blendConstants[3] = 0.0f;
+
+	state.pdssci.depthTestEnable = VK_TRUE;
+	if (graphics_settings->additive_blending) state.pdssci.depthWriteEnable = VK_FALSE;
+	else state.pdssci.depthWriteEnable = VK_TRUE;
+	state.pdssci.depthCompareOp = graphics_settings->depth_compare_op;
+	state.pdssci.depthBoundsTestEnable = VK_FALSE;
+	state.pdssci.minDepthBounds = 0.0f;
+	state.pdssci.maxDepthBounds = 1.0f;
+	state.pdssci.stencilTestEnable = graphics_settings->stencil_test ? VK_TRUE : VK_FALSE;
+	state.pdssci.front = graphics_settings->stencil_front;
+	state.pdssci.back = graphics_settings->stencil_back;
+
+	state.prci.colorAttachmentCount = graphics_settings->color_formats.size();
+	state.prci.pColorAttachmentFormats = graphics_settings->color_formats.data();
+	state.prci.depthAttachmentFormat = graphics_settings->depth_format;
+	state.prci.stencilAttachmentFormat = has_stencil(graphics_settings->depth_format) ? graphics_settings->depth_format : vk::Format::eUndefined;
+
+	state.gpci.pNext = &state.prci;
+	state.gpci.stageCount = shader_stages.size();
+	state.gpci.pStages = shader_stages.data();
+	state.gpci.pVertexInputState = &state.pvisci;
+	state.gpci.pInputAssemblyState = &state.piasci;
+	state.gpci.pViewportState = &state.pvsci;
+	state.gpci.pRasterizationState = &state.prsci;
+	state.gpci.pMultisampleState = &state.pmssci;
+	state.gpci.pDepthStencilState = &state.pdssci;
+	state.gpci.pColorBlendState = &state.pcbsci;
+	state.gpci.pDynamicState = &state.pdsci;
+	state.gpci.layout = pipeline_layout;
+	state.gpci.basePipelineHandle = VK_NULL_HANDLE;
+	state.gpci.basePipelineIndex = -1;
+}
+
+void Pipeline::create_layout()
+{
+	if (type == Type::Graphics) create_pipeline_layout(graphics_settings->set_layout, graphics_settings->pcrs);
+	else if (type == Type::Compute)
+	{
+		std::vector<vk::PushConstantRange> pcrs;
+		if (compute_settings->push_constant_byte_size > 0) pcrs.push_back(vk::PushConstantRange(vk::ShaderStageFlagBits::eCompute, 0, compute_settings->push_constant_byte_size));
+		create_pipeline_layout(compute_settings->set_layout, pcrs);
+	}
+}
+
+vk::ComputePipelineCreateInfo Pipeline::get_compute_create_info() const
+{
+	vk::ComputePipelineCreateInfo cpci;
+	cpci.stage = shader_stages[0];
+	cpci.layout = pipeline_layout;
+	return cpci;
+}
+
+void Pipeline::construct()
+{
+	create_layout();
 	if (type == Type::Graphics)
 	{
-		shader_stages.resize(graphics_settings->shaders.size());
-		spec_infos.resize(graphics_settings->shaders.size());
-		for (int32_t i = 0; i < graphics_settings->shaders.size(); i++)
+		if (use_shader_objects())
 		{
-			if (!compile_shader(vmc.logical_device.get(), vmc.shader_root_dir, graphics_settings->shaders[i], shader_stages[i], spec_infos[i])) return false;
+			// all state is set in bind(), only the shaders are created
+			create_shader_objects();
+			return;
+		}
+		GraphicsState state;
+		fill_graphics_state(state);
+		if (use_pipeline_libraries())
+		{
+			create_libraries(state.gpci);
+			pipeline = link_libraries(false);
+		}
+		else
+		{
+			vk::ResultValue<vk::Pipeline> pipeline_result_value = vmc.logical_device.get().createGraphicsPipeline(vmc.pipeline_cache.get(), state.gpci);
+			VKTE_CHECK(pipeline_result_value.result, "Failed to create pipeline!");
+			pipeline = pipeline_result_value.value;
 		}
 	}
 	else if (type == Type::Compute)
 	{
-		shader_stages.resize(1);
-		spec_infos.resize(1);
-		if (!compile_shader(vmc.logical_device.get(), vmc.shader_root_dir, compute_settings->shader, shader_stages[0], spec_infos[0])) return false;
+		vk::ResultValue<vk::Pipeline> comute_pipeline_result_value = vmc.logical_device.get().createComputePipeline(vmc.pipeline_cache.get(), get_compute_create_info());
+		VKTE_CHECK(comute_pipeline_result_value.result, "Failed to create compute pipeline!");
+		pipeline = comute_pipeline_result_value.value;
 	}
-	return true;
 }
 
-void Pipeline::construct()
+void Pipeline::construct(const std::vector<Pipeline*>& pipelines)
 {
-	if (type == Type::Graphics)
+	if (pipelines.empty()) return;
+	const VulkanMainContext& vmc = pipelines[0]->vmc;
+	std::vector<Pipeline*> graphics_pipelines;
+	std::vector<std::unique_ptr<GraphicsState>> graphics_states;
+	std::vector<vk::GraphicsPipelineCreateInfo> gpcis;
+	std::vector<Pipeline*> compute_pipelines;
+	std::vector<vk::ComputePipelineCreateInfo> cpcis;
+	for (Pipeline* pipeline : pipelines)
 	{
-		std::vector<vk::DynamicState> dynamic_states = {vk::DynamicState::eViewport, vk::DynamicState::eScissor};
-		if (vmc.get_features().device_features.dynamic_polygon_mode) dynamic_states.push_back(vk::DynamicState::ePolygonModeEXT);
-		vk::PipelineDynamicStateCreateInfo pdsci;
-		pdsci.dynamicStateCount = dynamic_states.size();
-		pdsci.pDynamicStates = dynamic_states.data();
-
-		vk::PipelineVertexInputStateCreateInfo pvisci;
-		pvisci.vertexBindingDescriptionCount = graphics_settings->binding_descriptions.size();
-		pvisci.pVertexBindingDescriptions = graphics_settings->binding_descriptions.data();
-		pvisci.vertexAttributeDescriptionCount = graphics_settings->attribute_description.size();
-		pvisci.pVertexAttributeDescriptions = graphics_settings->attribute_description.data();
-
-		vk::PipelineInputAssemblyStateCreateInfo piasci;
-		piasci.topology = graphics_settings->primitive_topology;
-		piasci.primitiveRestartEnable = VK_FALSE;
-
-		vk::PipelineViewportStateCreateInfo pvsci;
-		pvsci.viewportCount = 1;
-		pvsci.scissorCount = 1;
-
-		vk::PipelineRasterizationStateCreateInfo prsci;
-		prsci.depthClampEnable = VK_FALSE;
-		prsci.rasterizerDiscardEnable = VK_FALSE;
-		prsci.polygonMode = graphics_settings->polygon_mode;
-		prsci.lineWidth = 0.5f;
-		prsci.cullMode = vk::CullModeFlagBits::eNone;
-		prsci.frontFace = vk::FrontFace::eCounterClockwise;
-		prsci.depthBiasEnable = VK_FALSE;
-		prsci.depthBiasConstantFactor = 0.0f;
-		prsci.depthBiasClamp = 0.0f;
-		prsci.depthBiasSlopeFactor = 0.0f;
-
-		vk::PipelineMultisampleStateCreateInfo pmssci;
-		pmssci.sampleShadingEnable = VK_TRUE;
-		pmssci.rasterizationSamples = vk::SampleCountFlagBits::e1;
-		pmssci.minSampleShading = 0.4f;
-		pmssci.pSampleMask = nullptr;
-		pmssci.alphaToCoverageEnable = VK_FALSE;
-		pmssci.alphaToOneEnable = VK_FALSE;
-
-		std::vector<vk::PipelineColorBlendAttachmentState> pcbas(graphics_settings->color_formats.size());
-		for (uint32_t i = 0; i < graphics_settings->color_formats.size(); i++)
+		// shader objects have no pipeline
+		if (pipeline->use_shader_objects())
 		{
-			pcbas[i].colorWriteMask = vk::ColorComponentFlagBits::eR | vk::ColorComponentFlagBits::eG | vk::ColorComponentFlagBits::eB | vk::ColorComponentFlagBits::eA;
-			if (graphics_settings->additive_blending)
+			pipeline->construct();
+			continue;
+		}
+		pipeline->create_layout();
+		if (pipeline->type == Type::Graphics)
+		{
+			graphics_states.push_back(std::make_unique<GraphicsState>());
+			pipeline->fill_graphics_state(*graphics_states.back());
+			// libraries are already shared between the pipelines
+			if (pipeline->use_pipeline_libraries())
 			{
-				pcbas[i].blendEnable = VK_TRUE;
-				pcbas[i].srcColorBlendFactor = vk::BlendFactor::eSrcAlpha;
-				pcbas[i].dstColorBlendFactor = vk::BlendFactor::eOne;
+				pipeline->create_libraries(graphics_states.back()->gpci);
+				pipeline->pipeline = pipeline->link_libraries(false);
+				continue;
 			}
-			else
+			gpcis.push_back(graphics_states.back()->gpci);
+			graphics_pipelines.push_back(pipeline);
+		}
+		else if (pipeline->type == Type::Compute)
 		{
-				pcbas[i].blendEnable = VK_FALSE;
-				pcbas[i].srcColorBlendFactor = vk::BlendFactor::eOne;
-				pcbas[i].dstColorBlendFactor = vk::BlendFactor::eZero;
-			}
-			pcbas[i].colorBlendOp = vk::BlendOp::eAdd;
-			pcbas[i].srcAlphaBlendFactor = vk::BlendFactor::eOne;
-			pcbas[i].dstAlphaBlendFactor = vk::BlendFactor::eZero;
-			pcbas[i].alphaBlendOp = vk::BlendOp::eAdd;
+			cpcis.push_back(pipeline->get_compute_create_info());
+			compute_pipelines.push_back(pipeline);
 		}
+	}
+	// one call per type lets the driver compile the pipelines in parallel and look them up in the pipeline cache together
+	if (!gpcis.empty())
+	{
+		vk::ResultValue<std::vector<vk::Pipeline>> pipelines_result_value = vmc.logical_device.get().createGraphicsPipelines(vmc.pipeline_cache.get(), gpcis);
+		VKTE_CHECK(pipelines_result_value.result, "Failed to create pipelines!");
+		for (uint32_t i = 0; i < graphics_pipelines.size(); ++i) graphics_pipelines[i]->pipeline = pipelines_result_value.value[i];
+	}
+	if (!cpcis.empty())
+	{
+		vk::ResultValue<std::vector<vk::Pipeline>> pipelines_result_value = vmc.logical_device.get().createComputePipelines(vmc.pipeline_cache.get(), cpcis);
+		VKTE_CHECK(pipelines_result_value.result, "Failed to create compute pipelines!");
+		for (uint32_t i = 0; i < compute_pipelines.size(); ++i) compute_pipelines[i]->pipeline = pipelines_result_value.value[i];
+	}
+}
 
-		vk::PipelineColorBlendStateCreateInfo pcbsci;
-		pcbsci.logicOpEnable = VK_FALSE;
-		pcbsci.logicOp = vk::LogicOp::eCopy;
-		pcbsci.attachmentCount = pcbas.size();
-		pcbsci.pAttachments = pcbas.data();
-		pcbsci.blendConstants[0] = 0.0f;
-		pcbsci.blendConstants[1] = 0.0f;
-		pcbsci.blendConstants[2] = 0.0f;
-		pcbsci.blendConstants[3] = 0.0f;
-
-		vk::PipelineLayoutCreateInfo plci;
-		plci.setLayoutCount = 1;
-		plci.pSetLayouts = graphics_settings->set_layout;
-		plci.pushConstantRangeCount = graphics_settings->pcrs.size();
-		plci.pPushConstantRanges = graphics_settings->pcrs.data();
-
-		pipeline_layout = vmc.logical_device.get().createPipelineLayout(plci);
-
-		vk::PipelineDepthStencilStateCreateInfo pdssci;
-		pdssci.depthTestEnable = VK_TRUE;
-		if (graphics_settings->additive_blending) pdssci.depthWriteEnable = VK_FALSE;
-		else pdssci.depthWriteEnable = VK_TRUE;
-		pdssci.depthCompareOp = vk::CompareOp::eLess;
-		pdssci.depthBoundsTestEnable = VK_FALSE;
-		pdssci.minDepthBounds = 0.0f;
-		pdssci.maxDepthBounds = 1.0f;
-		pdssci.stencilTestEnable = VK_FALSE;
-		pdssci.front = vk::StencilOpState{};
-		pdssci.back = vk::StencilOpState{};
-
-		vk::PipelineRenderingCreateInfo prci;
-		prci.colorAttachmentCount = graphics_settings->color_formats.size();
-		prci.pColorAttachmentFormats = graphics_settings->color_formats.data();
-		prci.depthAttachmentFormat = graphics_settings->depth_format;
-		prci.stencilAttachmentFormat = has_stencil(graphics_settings->depth_format) ? graphics_settings->depth_format : vk::Format::eUndefined;
-
-		vk::GraphicsPipelineCreateInfo gpci;
-		gpci.pNext = &prci;
-		gpci.stageCount = shader_stages.size();
-		gpci.pStages = shader_stages.data();
-		gpci.pVertexInputState = &pvisci;
-		gpci.pInputAssemblyState = &piasci;
-		gpci.pViewportState = &pvsci;
-		gpci.pRasterizationState = &prsci;
-		gpci.pMultisampleState = &pmssci;
-		gpci.pDepthStencilState = &pdssci;
-		gpci.pColorBlendState = &pcbsci;
-		gpci.pDynamicState = &pdsci;
-		gpci.layout = pipeline_layout;
-		gpci.basePipelineHandle = VK_NULL_HANDLE;
-		gpci.basePipelineIndex = -1;
-
-		vk::ResultValue<vk::Pipeline> pipeline_result_value = vmc.logical_device.get().createGraphicsPipeline(VK_NULL_HANDLE, gpci);
-		VKTE_CHECK(pipeline_result_value.result, "Failed to create pipeline!");
-		pipeline = pipeline_result_value.value;
+bool Pipeline::use_pipeline_libraries() const
+{
+	if (type != Type::Graphics || !vmc.get_features().device_features.graphics_pipeline_library) return false;
+	// libraries are shared by the bindings of their layout, which are unknown for set layouts that were not created by the layout cache
+	return std::all_of(set_layouts.begin(), set_layouts.end(), [&](vk::DescriptorSetLayout set_layout) { return vmc.descriptor_set_layout_cache.get_binding_hash(set_layout).has_value(); });
+}
+
+bool Pipeline::use_shader_objects() const
+{
+	return type == Type::Graphics && vmc.get_features().device_features.shader_object;
+}
+
+void Pipeline::create_shader_objects()
+{
+	// there is no dynamic state for sample shading
+	if (graphics_settings->min_sample_shading > 0.0f) VKTE_WARN("vkte: Sample shading is not supported with shader objects and is ignored");
+	std::vector<vk::ShaderCreateInfoEXT> scis(shader_stages.size());
+	for (uint32_t i = 0; i < shader_stages.size(); ++i)
+	{
+		scis[i].stage = shader_stages[i].stage;
+		if (shader_stages[i].stage == vk::ShaderStageFlagBits::eVertex) scis[i].nextStage = vk::ShaderStageFlagBits::eFragment;
+		// the stages of one pipeline are linked, so that the driver can optimize across the interfaces like for a pipeline
+		if (shader_stages.size() > 1) scis[i].flags = vk::ShaderCreateFlagBitsEXT::eLinkStage;
+		scis[i].codeType = vk::ShaderCodeTypeEXT::eSpirv;
+		scis[i].codeSize = spirv_codes[i].size();
+		scis[i].pCode = spirv_codes[i].data();
+		scis[i].pName = shader_stages[i].pName;
+		scis[i].setSetLayouts(set_layouts);
+		scis[i].setPushConstantRanges(push_constant_ranges);
+		scis[i].pSpecializationInfo = shader_stages[i].pSpecializationInfo;
 	}
-	else if (type == Type::Compute)
+	vk::ResultValue<std::vector<vk::ShaderEXT>> shader_objects_result_value = vmc.logical_device.get().createShadersEXT(scis);
+	VKTE_CHECK(shader_objects_result_value.result, "Failed to create shader objects!");
+	shader_objects = shader_objects_result_value.value;
+}
+
+void Pipeline::bind(const vk::CommandBuffer& cb, const vk::Viewport& viewport, const vk::Rect2D& scissor) const
+{
+	if (is_fallback_used()) return fallback->bind(cb, viewport, scissor);
+	VKTE_ASSERT(is_ready(), "vkte: Trying to bind a pipeline whose construction is not finished!");
+	if (type == Type::Compute)
+	{
+		cb.bindPipeline(vk::PipelineBindPoint::eCompute, get());
+		return;
+	}
+	if (!use_shader_objects())
 	{
-		vk::PushConstantRange pcr;
-		pcr.offset = 0;
-		pcr.size = compute_settings->push_constant_byte_size;
-		pcr.stageFlags = vk::ShaderStageFlagBits::eCompute;
-
-		vk::PipelineLayoutCreateInfo plci;
-		plci.setLayoutCount = 1;
-		plci.pSetLayouts = compute_settings->set_layout;
-		if (compute_settings->push_constant_byte_size > 0)
+		cb.bindPipeline(vk::PipelineBindPoint::eGraphics, get());
+		cb.setViewport(0, viewport);
+		cb.setScissor(0, scissor);
+		return;
+	}
+
+	// stages without a shader of this pipeline are unbound, as a shader of a previously bound pipeline would be used otherwise
+	std::vector<vk::ShaderStageFlagBits> stages = {vk::ShaderStageFlagBits::eVertex, vk::ShaderStageFlagBits::eFragment};
+	std::vector<vk::ShaderEXT> shaders(stages.size(), VK_NULL_HANDLE);
+	for (uint32_t i = 0; i < shader_stages.size(); ++i)
+	{
+		auto stage = std::find(stages.begin(), stages.end(), shader_stages[i].stage);
+		if (stage == stages.end())
+		{
+			stages.push_back(shader_stages[i].stage);
+			shaders.push_back(shader_objects[i]);
+		}
+		else shaders[stage - stages.begin()] = shader_objects[i];
+	}
+	cb.bindShadersEXT(stages, shaders);
+
+	// the same state that construct() bakes into the pipeline
+	const GraphicsSettings& gs = *graphics_settings;
+	cb.setViewportWithCount(viewport);
+	cb.setScissorWithCount(scissor);
+	std::vector<vk::VertexInputBindingDescription2EXT> bindings;
+	for (const vk::VertexInputBindingDescription& b : gs.binding_descriptions) bindings.push_back(vk::VertexInputBindingDescription2EXT(b.binding, b.stride, b.inputRate, 1));
+	std::vector<vk::VertexInputAttributeDescription2EXT> attributes;
+	for (const vk::VertexInputAttributeDescription& a : gs.attribute_description) attributes.push_back(vk::VertexInputAttributeDescription2EXT(a.location, a.binding, a.format, a.offset));
+	cb.setVertexInputEXT(bindings, attributes);
+	cb.setPrimitiveTopology(gs.primitive_topology);
+	cb.setPrimitiveRestartEnable(VK_FALSE);
+	cb.setRasterizerDiscardEnable(VK_FALSE);
+	cb.setDepthClampEnableEXT(VK_FALSE);
+	cb.setPolygonModeEXT(gs.polygon_mode);
+	cb.setLineWidth(0.5f);
+	cb.setCullMode(gs.cull_mode);
+	cb.setFrontFace(gs.front_face);
+	cb.setDepthBiasEnable(gs.depth_bias ? VK_TRUE : VK_FALSE);
+	if (gs.depth_bias) cb.setDepthBias(gs.depth_bias_constant_factor, gs.depth_bias_clamp, gs.depth_bias_slope_factor);
+	cb.setRasterizationSamplesEXT(gs.sample_count);
+	const vk::SampleMask sample_mask = ~0u;
+	cb.setSampleMaskEXT(gs.sample_count, sample_mask);
+	cb.setAlphaToCoverageEnableEXT(VK_FALSE);
+	cb.setDepthTestEnable(VK_TRUE);
+	cb.setDepthWriteEnable(gs.additive_blending ? VK_FALSE : VK_TRUE);
+	cb.setDepthCompareOp(gs.depth_compare_op);
+	cb.setDepthBoundsTestEnable(VK_FALSE);
+	cb.setStencilTestEnable(gs.stencil_test ? VK_TRUE : VK_FALSE);
+	if (gs.stencil_test)
+	{
+		for (const auto& [face, stencil] : {std::pair(vk::StencilFaceFlagBits::eFront, gs.stencil_front), std::pair(vk::StencilFaceFlagBits::eBack, gs.stencil_back)})
 		{
-			plci.pushConstantRangeCount = 1;
-			plci.pPushConstantRanges = &pcr;
+			cb.setStencilOp(face, stencil.failOp, stencil.passOp, stencil.depthFailOp, stencil.compareOp);
+			cb.setStencilCompareMask(face, stencil.compareMask);
+			cb.setStencilWriteMask(face, stencil.writeMask);
+			cb.setStencilReference(face, stencil.reference);
 		}
+	}
+	if (gs.color_formats.empty()) return;
+	std::vector<vk::Bool32> blend_enables;
+	std::vector<vk::ColorBlendEquationEXT> blend_equations;
+	std::vector<vk::ColorComponentFlags> write_masks;
+	for (const vk::PipelineColorBlendAttachmentState& pcbas : get_blend_states())
+	{
+		blend_enables.push_back(pcbas.blendEnable);
+		blend_equations.push_back(vk::ColorBlendEquationEXT(pcbas.srcColorBlendFactor, pcbas.dstColorBlendFactor, pcbas.colorBlendOp, pcbas.srcAlphaBlendFactor, pcbas.dstAlphaBlendFactor, pcbas.alphaBlendOp));
+		write_masks.push_back(pcbas.colorWriteMask);
+	}
+	cb.setColorBlendEnableEXT(0, blend_enables);
+	cb.setColorBlendEquationEXT(0, blend_equations);
+	cb.setColorWriteMaskEXT(0, write_masks);
+}
+
+template<typename T>
+uint64_t hash_vector(const std::vector<T>& data, uint64_t hash)
+{
+	const uint64_t size = data.size();
+	return hash_bytes(data.data(), sizeof(T) * data.size(), hash_bytes(&size, sizeof(size), hash));
+}
+
+template<typename T>
+uint64_t hash_value(const T& value, uint64_t hash)
+{
+	return hash_bytes(&value, sizeof(T), hash);
+}
 
-		pipeline_layout = vmc.logical_device.get().createPipelineLayout(plci);
+uint64_t Pipeline::hash_shader_stages(bool fragment, uint64_t hash) const
+{
+	for (uint32_t i = 0; i < graphics_settings->shaders.size(); ++i)
+	{
+		const Shader& shader = graphics_settings->shaders[i];
+		if ((shader.stage_flag == vk::ShaderStageFlagBits::eFragment) != fragment) continue;
+		hash = hash_value(spirv_hashes[i], hash);
+		hash = hash_value(shader.stage_flag, hash);
+		hash = hash_vector(shader.get_spec_entries(), hash);
+		hash = hash_vector(shader.get_spec_entries_data(), hash);
+	}
+	// libraries with shaders can only be linked with a compatible layout, which is identically defined if the set layout and push constants match
+	// the bindings are hashed instead of the handles, as the handle of a destroyed layout may be reused while the library is still cached
+	for (vk::DescriptorSetLayout set_layout : set_layouts) hash = hash_value(vmc.descriptor_set_layout_cache.get_binding_hash(set_layout).value(), hash);
+	return hash_vector(push_constant_ranges, hash);
+}
 
-		vk::ComputePipelineCreateInfo cpci;
-		cpci.stage = shader_stages[0];
-		cpci.layout = pipeline_layout;
+std::array<uint64_t, 4> Pipeline::get_library_keys() const
+{
+	// the keys cover the settings that the state of each part is derived from in construct()
+	const GraphicsSettings& gs = *graphics_settings;
+	const bool dynamic_polygon_mode = vmc.get_features().device_features.dynamic_polygon_mode;
+	std::array<uint64_t, 4> keys;
+	keys[0] = hash_vector(gs.binding_descriptions, hash_offset_basis);
+	keys[0] = hash_vector(gs.attribute_description, keys[0]);
+	keys[0] = hash_value(gs.primitive_topology, keys[0]);
+	keys[1] = hash_shader_stages(false, hash_offset_basis);
+	keys[1] = hash_value(gs.polygon_mode, keys[1]);
+	keys[1] = hash_value(dynamic_polygon_mode, keys[1]);
+	keys[1] = hash_value(gs.cull_mode, keys[1]);
+	keys[1] = hash_value(gs.front_face, keys[1]);
+	keys[1] = hash_value(gs.depth_bias, keys[1]);
+	keys[1] = hash_value(gs.depth_bias_constant_factor, keys[1]);
+	keys[1] = hash_value(gs.depth_bias_clamp, keys[1]);
+	keys[1] = hash_value(gs.depth_bias_slope_factor, keys[1]);
+	keys[2] = hash_shader_stages(true, hash_offset_basis);
+	keys[2] = hash_value(gs.additive_blending, keys[2]);
+	keys[2] = hash_value(gs.depth_format, keys[2]);
+	keys[2] = hash_value(gs.depth_compare_op, keys[2]);
+	keys[2] = hash_value(gs.stencil_test, keys[2]);
+	keys[2] = hash_value(gs.stencil_front, keys[2]);
+	keys[2] = hash_value(gs.stencil_back, keys[2]);
+	keys[2] = hash_value(gs.sample_count, keys[2]);
+	keys[2] = hash_value(gs.min_sample_shading, keys[2]);
+	keys[3] = hash_vector(gs.color_formats, hash_offset_basis);
+	keys[3] = hash_value(gs.depth_format, keys[3]);
+	keys[3] = hash_vector(get_blend_states(), keys[3]);
+	keys[3] = hash_value(gs.sample_count, keys[3]);
+	keys[3] = hash_value(gs.min_sample_shading, keys[3]);
+	return keys;
+}
 
-		vk::ResultValue<vk::Pipeline> comute_pipeline_result_value = vmc.logical_device.get().createComputePipeline(VK_NULL_HANDLE, cpci);
-		VKTE_CHECK(comute_pipeline_result_value.result, "Failed to create compute pipeline!");
-		pipeline = comute_pipeline_result_value.value;
+void Pipeline::create_libraries(const vk::GraphicsPipelineCreateInfo& gpci)
+{
+	// every library is created from the state of the complete pipeline that belongs to its part
+	auto create_library = [&](vk::GraphicsPipelineLibraryFlagBitsEXT part, vk::GraphicsPipelineCreateInfo lci) {
+		vk::GraphicsPipelineLibraryCreateInfoEXT gplci(part);
+		gplci.pNext = lci.pNext;
+		lci.pNext = &gplci;
+		// the link time optimization information is needed for optimize_async()
+		lci.flags |= vk::PipelineCreateFlagBits::eLibraryKHR | vk::PipelineCreateFlagBits::eRetainLinkTimeOptimizationInfoEXT;
+		vk::ResultValue<vk::Pipeline> library = vmc.logical_device.get().createGraphicsPipeline(vmc.pipeline_cache.get(), lci);
+		VKTE_CHECK(library.result, "Failed to create pipeline library!");
+		return library.value;
+	};
+	std::vector<vk::PipelineShaderStageCreateInfo> pre_rasterization_stages;
+	std::vector<vk::PipelineShaderStageCreateInfo> fragment_stages;
+	for (const vk::PipelineShaderStageCreateInfo& pssci : shader_stages)
+	{
+		if (pssci.stage == vk::ShaderStageFlagBits::eFragment) fragment_stages.push_back(pssci);
+		else pre_rasterization_stages.push_back(pssci);
 	}
+	const std::array<uint64_t, 4> keys = get_library_keys();
+	PipelineLibraryCache& cache = vmc.pipeline_library_cache;
+
+	libraries[0] = cache.get(PipelineLibraryCache::Part::VertexInput, keys[0], [&]() {
+		vk::GraphicsPipelineCreateInfo lci;
+		lci.pVertexInputState = gpci.pVertexInputState;
+		lci.pInputAssemblyState = gpci.pInputAssemblyState;
+		lci.pDynamicState = gpci.pDynamicState;
+		return create_library(vk::GraphicsPipelineLibraryFlagBitsEXT::eVertexInputInterface, lci);
+	});
+	libraries[1] = cache.get(PipelineLibraryCache::Part::PreRasterization, keys[1], [&]() {
+		vk::GraphicsPipelineCreateInfo lci;
+		lci.pNext = gpci.pNext;
+		lci.setStages(pre_rasterization_stages);
+		lci.pViewportState = gpci.pViewportState;
+		lci.pRasterizationState = gpci.pRasterizationState;
+		lci.pDynamicState = gpci.pDynamicState;
+		lci.layout = gpci.layout;
+		return create_library(vk::GraphicsPipelineLibraryFlagBitsEXT::ePreRasterizationShaders, lci);
+	});
+	libraries[2] = cache.get(PipelineLibraryCache::Part::FragmentShader, keys[2], [&]() {
+		vk::GraphicsPipelineCreateInfo lci;
+		lci.pNext = gpci.pNext;
+		lci.setStages(fragment_stages);
+		lci.pMultisampleState = gpci.pMultisampleState;
+		lci.pDepthStencilState = gpci.pDepthStencilState;
+		lci.pDynamicState = gpci.pDynamicState;
+		lci.layout = gpci.layout;
+		return create_library(vk::GraphicsPipelineLibraryFlagBitsEXT::eFragmentShader, lci);
+	});
+	libraries[3] = cache.get(PipelineLibraryCache::Part::FragmentOutput, keys[3], [&]() {
+		vk::GraphicsPipelineCreateInfo lci;
+		lci.pNext = gpci.pNext;
+		lci.pMultisampleState = gpci.pMultisampleState;
+		lci.pColorBlendState = gpci.pColorBlendState;
+		lci.pDynamicState = gpci.pDynamicState;
+		return create_library(vk::GraphicsPipelineLibraryFlagBitsEXT::eFragmentOutputInterface, lci);
+	});
 }
 
-void Pipeline::reconstruct()
+vk::Pipeline Pipeline::link_libraries(bool optimize) const
+{
+	vk::PipelineLibraryCreateInfoKHR plci(libraries);
+	vk::GraphicsPipelineCreateInfo gpci;
+	gpci.pNext = &plci;
+	gpci.layout = pipeline_layout;
+	// without link time optimization the libraries are only linked, which is fast enough to be done while rendering
+	if (optimize) gpci.flags = vk::PipelineCreateFlagBits::eLinkTimeOptimizationEXT;
+	vk::ResultValue<vk::Pipeline> linked_pipeline = vmc.logical_device.get().createGraphicsPipeline(vmc.pipeline_cache.get(), gpci);
+	VKTE_CHECK(linked_pipeline.result, "Failed to link pipeline libraries!");
+	return linked_pipeline.value;
+}
+
+std::shared_future<bool> Pipeline::optimize_async(WorkerPool& pool)
 {
+	VKTE_ASSERT(type == Type::Graphics, "vkte: Only graphics pipelines can be optimized!");
+	VKTE_ASSERT(!optimization.valid(), "vkte: Pipeline is already optimized!");
+	if (!libraries[0])
+	{
+		// a pipeline that is not linked from libraries is created with all optimizations already
+		std::promise<bool> optimized;
+		optimized.set_value(true);
+		optimization = optimized.get_future().share();
+		return optimization;
+	}
+	optimization = pool.submit([this]() {
+		try
+		{
+			optimized_pipeline = link_libraries(true);
+			return true;
+		}
+		catch (const std::exception& e)
+		{
+			VKTE_ERROR("vkte: Failed to optimize pipeline: {}", e.what());
+			return false;
+		}
+	}).share();
+	return optimization;
+}
+
+bool Pipeline::is_optimized() const
+{
+	return optimization.valid() && optimization.wait_for(std::chrono::seconds(0)) == std::future_status::ready && optimization.get();
+}
+
+void Pipeline::destroy_pipeline()
+{
+	if (optimization.valid()) optimization.wait();
+	optimization = {};
+	vmc.logical_device.get().destroyPipeline(optimized_pipeline);
+	optimized_pipeline = VK_NULL_HANDLE;
+	// the libraries belong to the library cache
+	libraries = {};
+	for (vk::ShaderEXT shader_object : shader_objects) vmc.logical_device.get().destroyShaderEXT(shader_object);
+	shader_objects.clear();
 	vmc.logical_device.get().destroyPipeline(pipeline);
+	pipeline = VK_NULL_HANDLE;
 	vmc.logical_device.get().destroyPipelineLayout(pipeline_layout);
+	if (reflected_layout)
+	{
+		for (vk::DescriptorSetLayout set_layout : set_layouts) vmc.descriptor_set_layout_cache.release(set_layout);
+	}
+	set_layouts.clear();
+	push_constant_ranges.clear();
+}
+
+std::shared_future<bool> Pipeline::construct_async(WorkerPool& pool, const Pipeline* fallback)
+{
+	VKTE_ASSERT(is_ready(), "vkte: Pipeline is already being constructed!");
+	// like reconstruct(), a previously constructed pipeline is replaced
+	destroy_pipeline();
+	this->fallback = fallback;
+	construction = pool.submit([this]() {
+		// exceptions must not leave the worker thread, they are reported through the future
+		try
+		{
+			// the pool already runs multiple constructions in parallel, so each one compiles its shaders sequentially
+			if (!compile_shaders(1)) return false;
+			construct();
+			return true;
+		}
+		catch (const std::exception& e)
+		{
+			VKTE_ERROR("vkte: Failed to construct pipeline: {}", e.what());
+			return false;
+		}
+	}).share();
+	return construction;
+}
+
+bool Pipeline::is_ready() const
+{
+	return !construction.valid() || construction.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+}
+
+bool Pipeline::is_fallback_used() const
+{
+	// a failed construction keeps using the fallback
+	return fallback && (!is_ready() || (construction.valid() && !construction.get()));
+}
+
+void Pipeline::reconstruct()
+{
+	if (construction.valid()) construction.wait();
+	destroy_pipeline();
 	construct();
 }
 
+void Pipeline::swap(Pipeline& other)
+{
+	VKTE_ASSERT(type == other.type, "vkte: Only pipelines of the same type can be swapped!");
+	// running jobs write into the pipeline they were started for
+	for (Pipeline* p : {this, &other})
+	{
+		if (p->construction.valid()) p->construction.wait();
+		if (p->optimization.valid()) p->optimization.wait();
+	}
+	// the specialization infos point into the settings, so both are swapped together
+	std::swap(graphics_settings, other.graphics_settings);
+	std::swap(compute_settings, other.compute_settings);
+	std::swap(pipeline_layout, other.pipeline_layout);
+	std::swap(pipeline, other.pipeline);
+	std::swap(shader_stages, other.shader_stages);
+	std::swap(spec_infos, other.spec_infos);
+	std::swap(spirv_hashes, other.spirv_hashes);
+	std::swap(spirv_codes, other.spirv_codes);
+	std::swap(shader_objects, other.shader_objects);
+	std::swap(construction, other.construction);
+	std::swap(fallback, other.fallback);
+	std::swap(libraries, other.libraries);
+	std::swap(optimized_pipeline, other.optimized_pipeline);
+	std::swap(optimization, other.optimization);
+	std::swap(reflection, other.reflection);
+	std::swap(set_layouts, other.set_layouts);
+	std::swap(push_constant_ranges, other.push_constant_ranges);
+	std::swap(reflected_layout, other.reflected_layout);
+}
+
 void Pipeline::destruct()
 {
-	for (vk::PipelineShaderStageCreateInfo& pssci : shader_stages) vmc.logical_device.get().destroyShaderModule(pssci.module);
+	if (construction.valid()) construction.wait();
+	construction = {};
+	fallback = nullptr;
+	for (vk::PipelineShaderStageCreateInfo& pssci : shader_stages) vmc.shader_module_cache.release(pssci.module);
 	shader_stages.clear();
 	spec_infos.clear();
-	vmc.logical_device.get().destroyPipeline(pipeline);
-	vmc.logical_device.get().destroyPipelineLayout(pipeline_layout);
+	spirv_hashes.clear();
+	spirv_codes.clear();
+	destroy_pipeline();
 }
 
+// returned while an asynchronous construction without fallback is running, as the handles are written by the worker thread
+const vk::Pipeline null_pipeline = VK_NULL_HANDLE;
+const vk::PipelineLayout null_pipeline_layout = VK_NULL_HANDLE;
+
 const vk::Pipeline& Pipeline::get() const
 {
+	if (is_fallback_used()) return fallback->get();
+	if (!is_ready()) return null_pipeline;
+	if (optimized_pipeline && is_optimized()) return optimized_pipeline;
 	return pipeline;
 }
 
 const vk::PipelineLayout& Pipeline::get_layout() const
 {
+	if (is_fallback_used()) return fallback->get_layout();
+	if (!is_ready()) return null_pipeline_layout;
 	return pipeline_layout;
 }
+
+const std::vector<vk::DescriptorSetLayout>& Pipeline::get_set_layouts() const
+{
+	return set_layouts;
+}
+
+const ShaderReflection& Pipeline::get_reflection() const
+{
+	return reflection;
+}
+
+std::array<uint32_t, 3> Pipeline::get_local_size() const
+{
+	VKTE_ASSERT(type == Type::Compute, "vkte: Only compute pipelines have a local size!");
+	return reflection.local_size;
+}
 } // namespace vkte
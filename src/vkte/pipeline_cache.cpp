@@ -0,0 +1,108 @@
+#include "vkte/pipeline_cache.hpp"
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include "vkte/vkte_log.hpp"
+
+namespace vkte
+{
+void PipelineCache::construct(const vk::Device& device, const vk::PhysicalDevice& physical_device, const std::string& file_path)
+{
+	this->device = device;
+	this->file_path = file_path;
+	const std::vector<char> data = load(physical_device);
+	vk::PipelineCacheCreateInfo pcci;
+	pcci.initialDataSize = data.size();
+	pcci.pInitialData = data.data();
+	cache = device.createPipelineCache(pcci);
+	saved_byte_size = data.size();
+	stop = false;
+	save_thread = std::thread([this]() {
+		std::unique_lock<std::mutex> lock(stop_mutex);
+		while (!stop_cv.wait_for(lock, save_interval, [this]() { return stop; })) save();
+	});
+}
+
+void PipelineCache::destruct()
+{
+	{
+		std::lock_guard<std::mutex> lock(stop_mutex);
+		stop = true;
+	}
+	stop_cv.notify_one();
+	save_thread.join();
+	save();
+	device.destroyPipelineCache(cache);
+}
+
+std::vector<char> PipelineCache::load(const vk::PhysicalDevice& physical_device) const
+{
+	std::ifstream file(file_path, std::ios::binary | std::ios::ate);
+	if (!file.is_open()) return {};
+	std::vector<char> data(file.tellg());
+	file.seekg(0);
+	file.read(data.data(), data.size());
+
+	// the data of other devices or drivers would be rejected by the driver anyway, some drivers do not validate it though
+	VkPipelineCacheHeaderVersionOne header;
+	if (data.size() < sizeof(header))
+	{
+		VKTE_WARN("vkte: Pipeline cache \"{}\" is too small, it is ignored", file_path);
+		return {};
+	}
+	memcpy(&header, data.data(), sizeof(header));
+	const vk::PhysicalDeviceProperties properties = physical_device.getProperties();
+	if (header.headerSize < sizeof(header) || header.headerVersion != VK_PIPELINE_CACHE_HEADER_VERSION_ONE || header.vendorID != properties.vendorID || header.deviceID != properties.deviceID || memcmp(header.pipelineCacheUUID, properties.pipelineCacheUUID.data(), VK_UUID_SIZE) != 0)
+	{
+		VKTE_INFO("vkte: Pipeline cache \"{}\" was created by another device or driver, it is ignored", file_path);
+		return {};
+	}
+	return data;
+}
+
+void PipelineCache::save()
+{
+	std::lock_guard<std::mutex> lock(save_mutex);
+	// pipeline caches only grow, so an unchanged size means that no pipeline was added
+	std::size_t byte_size = 0;
+	VKTE_CHECK(device.getPipelineCacheData(cache, &byte_size, nullptr), "Failed to get pipeline cache size!");
+	if (byte_size == saved_byte_size) return;
+	std::vector<char> data;
+	vk::Result result;
+	do
+	{
+		// pipelines that are created by other threads in the meantime make the data larger than the queried size
+		data.resize(byte_size);
+		result = device.getPipelineCacheData(cache, &byte_size, data.data());
+		if (result == vk::Result::eIncomplete) VKTE_CHECK(device.getPipelineCacheData(cache, &byte_size, nullptr), "Failed to get pipeline cache size!");
+	} while (result == vk::Result::eIncomplete);
+	VKTE_CHECK(result, "Failed to get pipeline cache data!");
+
+	// the cache is written to a temporary file first, so that an interrupted write does not leave a broken cache behind
+	const std::filesystem::path path(file_path);
+	const std::filesystem::path tmp_path(file_path + ".tmp");
+	std::error_code error;
+	std::filesystem::create_directories(path.parent_path(), error);
+	{
+		std::ofstream file(tmp_path, std::ios::binary | std::ios::trunc);
+		if (!file.is_open() || !file.write(data.data(), byte_size))
+		{
+			VKTE_WARN("vkte: Failed to write pipeline cache \"{}\"", tmp_path.string());
+			return;
+		}
+	}
+	std::filesystem::rename(tmp_path, path, error);
+	if (error)
+	{
+		VKTE_WARN("vkte: Failed to replace pipeline cache \"{}\": {}", file_path, error.message());
+		return;
+	}
+	saved_byte_size = byte_size;
+}
+
+vk::PipelineCache PipelineCache::get() const
+{
+	return cache;
+}
+} // namespace vkte
@@ -0,0 +1,42 @@
+#include "vkte/pipeline_library_cache.hpp"
+
+namespace vkte
+{
+void PipelineLibraryCache::construct(const vk::Device& device)
+{
+	this->device = device;
+}
+
+void PipelineLibraryCache::destruct()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	for (std::unordered_map<uint64_t, vk::Pipeline>& part_libraries : libraries)
+	{
+		for (const std::pair<const uint64_t, vk::Pipeline>& library : part_libraries) device.destroyPipeline(library.second);
+		part_libraries.clear();
+	}
+}
+
+vk::Pipeline PipelineLibraryCache::get(Part part, uint64_t key, const std::function<vk::Pipeline()>& create)
+{
+	std::unordered_map<uint64_t, vk::Pipeline>& part_libraries = libraries[uint32_t(part)];
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		auto it = part_libraries.find(key);
+		if (it != part_libraries.end()) return it->second;
+	}
+	// the library is compiled without holding the lock, so that other libraries can be compiled at the same time
+	vk::Pipeline library = create();
+	std::lock_guard<std::mutex> lock(mutex);
+	auto [it, inserted] = part_libraries.emplace(key, library);
+	// another thread created the same library in the meantime
+	if (!inserted) device.destroyPipeline(library);
+	return it->second;
+}
+
+uint32_t PipelineLibraryCache::get_library_count() const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return libraries[0].size() + libraries[1].size() + libraries[2].size() + libraries[3].size();
+}
+} // namespace vkte
@@ -0,0 +1,166 @@
+#include "vkte/pipeline_permutations.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <charconv>
+#include <fstream>
+#include <sstream>
+#include "vkte/vkte_log.hpp"
+
+namespace vkte
+{
+PipelinePermutations::PipelinePermutations(const VulkanMainContext& vmc, Pipeline::Type type) : vmc(vmc), type(type)
+{}
+
+Pipeline::GraphicsSettings& PipelinePermutations::get_graphics_settings()
+{
+	VKTE_ASSERT(type == Pipeline::Type::Graphics, "vkte: Invalid access to graphics pipeline settings!");
+	return graphics_settings;
+}
+
+Pipeline::ComputeSettings& PipelinePermutations::get_compute_settings()
+{
+	VKTE_ASSERT(type == Pipeline::Type::Compute, "vkte: Invalid access to compute pipeline settings!");
+	return compute_settings;
+}
+
+uint32_t PipelinePermutations::add_axis(const std::string& name, uint32_t constant_id, uint32_t value_count)
+{
+	VKTE_ASSERT(value_count > 0, "vkte: Permutation axis \"" + name + "\" needs at least one value!");
+	VKTE_ASSERT(pipelines.empty(), "vkte: Permutation axes must be added before the variants are constructed!");
+	const uint32_t axis_bit_count = std::bit_width(value_count - 1);
+	VKTE_ASSERT(bit_count + axis_bit_count <= 64, "vkte: Permutation axes do not fit into a 64 bit key!");
+	axes.push_back(Axis{name, constant_id, value_count, bit_count, axis_bit_count});
+	bit_count += axis_bit_count;
+	return axes.size() - 1;
+}
+
+uint64_t PipelinePermutations::get_key(const std::vector<uint32_t>& values) const
+{
+	VKTE_ASSERT(values.size() == axes.size(), "vkte: Permutation needs one value per axis!");
+	uint64_t key = 0;
+	for (uint32_t i = 0; i < axes.size(); ++i)
+	{
+		VKTE_ASSERT(values[i] < axes[i].value_count, "vkte: Value of permutation axis \"" + axes[i].name + "\" is out of range!");
+		key |= uint64_t(values[i]) << axes[i].bit_offset;
+	}
+	return key;
+}
+
+bool PipelinePermutations::construct(const std::vector<std::vector<uint32_t>>& variants)
+{
+	std::vector<std::unique_ptr<Pipeline>> new_pipelines;
+	std::vector<uint64_t> keys;
+	for (const std::vector<uint32_t>& values : variants)
+	{
+		const uint64_t key = get_key(values);
+		if (pipelines.contains(key) || std::find(keys.begin(), keys.end(), key) != keys.end()) continue;
+		std::unique_ptr<Pipeline> pipeline = std::make_unique<Pipeline>(vmc, type);
+		std::vector<Shader*> shaders;
+		if (type == Pipeline::Type::Graphics)
+		{
+			pipeline->get_graphics_settings() = graphics_settings;
+			for (Shader& shader : pipeline->get_graphics_settings().shaders) shaders.push_back(&shader);
+		}
+		else
+		{
+			pipeline->get_compute_settings() = compute_settings;
+			shaders.push_back(&pipeline->get_compute_settings().shader);
+		}
+		for (Shader* shader : shaders)
+		{
+			for (uint32_t i = 0; i < axes.size(); ++i) shader->add_specialization_constant<uint32_t>(axes[i].constant_id, values[i]);
+		}
+		new_pipelines.push_back(std::move(pipeline));
+		keys.push_back(key);
+	}
+	if (new_pipelines.empty()) return true;
+
+	// all variants use the same SPIR-V, so every shader is compiled once and the modules are shared through the module cache
+	std::vector<Pipeline*> pipeline_ptrs;
+	for (std::unique_ptr<Pipeline>& pipeline : new_pipelines) pipeline_ptrs.push_back(pipeline.get());
+	if (!Pipeline::compile_shaders(pipeline_ptrs))
+	{
+		for (std::unique_ptr<Pipeline>& pipeline : new_pipelines) pipeline->destruct();
+		return false;
+	}
+	try
+	{
+		Pipeline::construct(pipeline_ptrs);
+	}
+	catch (...)
+	{
+		for (std::unique_ptr<Pipeline>& pipeline : new_pipelines) pipeline->destruct();
+		throw;
+	}
+	for (uint32_t i = 0; i < new_pipelines.size(); ++i) pipelines.emplace(keys[i], std::move(new_pipelines[i]));
+	VKTE_INFO("vkte: Created {} pipeline permutation(s)", keys.size());
+	return true;
+}
+
+bool PipelinePermutations::construct_from_manifest(const std::string& path)
+{
+	std::ifstream file(path);
+	if (!file.is_open())
+	{
+		VKTE_ERROR("vkte: Failed to open permutation manifest \"{}\"", path);
+		return false;
+	}
+	std::vector<std::vector<uint32_t>> variants;
+	std::string line;
+	uint32_t line_number = 0;
+	while (std::getline(file, line))
+	{
+		line_number++;
+		line = line.substr(0, line.find('#'));
+		std::istringstream tokens(line);
+		std::vector<uint32_t> values(axes.size(), 0);
+		bool empty = true;
+		for (std::string token; tokens >> token;)
+		{
+			empty = false;
+			const std::size_t separator = token.find('=');
+			const std::string name = token.substr(0, separator);
+			auto axis = std::find_if(axes.begin(), axes.end(), [&](const Axis& a) { return a.name == name; });
+			if (separator == std::string::npos || axis == axes.end())
+			{
+				VKTE_ERROR("vkte: Invalid permutation \"{}\" in line {} of \"{}\"", token, line_number, path);
+				return false;
+			}
+			uint32_t value = 0;
+			const std::from_chars_result result = std::from_chars(token.data() + separator + 1, token.data() + token.size(), value);
+			if (result.ec != std::errc() || result.ptr != token.data() + token.size() || value >= axis->value_count)
+			{
+				VKTE_ERROR("vkte: Invalid value of permutation axis \"{}\" in line {} of \"{}\"", name, line_number, path);
+				return false;
+			}
+			values[axis - axes.begin()] = value;
+		}
+		if (!empty) variants.push_back(std::move(values));
+	}
+	return construct(variants);
+}
+
+void PipelinePermutations::destruct()
+{
+	for (std::pair<const uint64_t, std::unique_ptr<Pipeline>>& pipeline : pipelines) pipeline.second->destruct();
+	pipelines.clear();
+}
+
+bool PipelinePermutations::contains(uint64_t key) const
+{
+	return pipelines.contains(key);
+}
+
+const Pipeline& PipelinePermutations::get(uint64_t key) const
+{
+	auto it = pipelines.find(key);
+	VKTE_ASSERT(it != pipelines.end(), "vkte: Pipeline permutation was not constructed!");
+	return *it->second;
+}
+
+uint32_t PipelinePermutations::get_variant_count() const
+{
+	return pipelines.size();
+}
+} // namespace vkte
@@ -0,0 +1,537 @@
+#include "vkte/pixel_conversion.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include "vkte/vkte_log.hpp"
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define VKTE_PIXEL_CONVERSION_X86 1
+#include <immintrin.h>
+#else
+#define VKTE_PIXEL_CONVERSION_X86 0
+#endif
+
+namespace vkte
+{
+float half_to_float(uint16_t h)
+{
+	const uint32_t sign = uint32_t(h & 0x8000u) << 16;
+	uint32_t exponent = (h >> 10) & 0x1fu;
+	uint32_t mantissa = h & 0x3ffu;
+	uint32_t bits;
+	if (exponent == 0x1fu) bits = sign | 0x7f800000u | (mantissa << 13);
+	else if (exponent != 0) bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+	else if (mantissa == 0) bits = sign;
+	else
+	{
+		// renormalize denormals
+		exponent = 113;
+		while (!(mantissa & 0x400u))
+		{
+			mantissa <<= 1;
+			exponent--;
+		}
+		bits = sign | (exponent << 23) | ((mantissa & 0x3ffu) << 13);
+	}
+	float f;
+	memcpy(&f, &bits, sizeof(float));
+	return f;
+}
+
+uint16_t float_to_half(float f)
+{
+	uint32_t bits;
+	memcpy(&bits, &f, sizeof(float));
+	const uint16_t sign = (bits >> 16) & 0x8000u;
+	const int32_t exponent = int32_t((bits >> 23) & 0xffu) - 112;
+	uint32_t mantissa = bits & 0x7fffffu;
+	if (exponent >= 0x1f)
+	{
+		// keep nans as nans, everything else that is too large becomes infinity
+		const bool nan = ((bits >> 23) & 0xffu) == 0xffu && mantissa != 0;
+		return sign | 0x7c00u | (nan ? 0x200u : 0u);
+	}
+	if (exponent <= 0)
+	{
+		if (exponent < -10) return sign;
+		// denormal, round to nearest even
+		mantissa |= 0x800000u;
+		const uint32_t shift = 14 - exponent;
+		const uint32_t half_mantissa = mantissa >> shift;
+		const uint32_t remainder = mantissa & ((1u << shift) - 1);
+		const uint32_t halfway = 1u << (shift - 1);
+		return sign | (half_mantissa + (remainder > halfway || (remainder == halfway && (half_mantissa & 1u))));
+	}
+	// round to nearest even, a carry into the exponent is the correct result
+	const uint32_t half_bits = (uint32_t(exponent) << 10) | (mantissa >> 13);
+	const uint32_t remainder = mantissa & 0x1fffu;
+	return sign | (half_bits + (remainder > 0x1000u || (remainder == 0x1000u && (half_bits & 1u))));
+}
+
+// lookup tables shared by all implementations so that they produce the same results
+struct SRGBTables
+{
+	std::array<float, 256> to_linear;
+	// indexed by the linear value quantized to 12 bit, stored as 32 bit to allow gathers
+	std::array<uint32_t, 4096> to_srgb;
+};
+
+const SRGBTables& get_srgb_tables()
+{
+	static const SRGBTables tables = []() {
+		SRGBTables t;
+		for (uint32_t i = 0; i < t.to_linear.size(); ++i)
+		{
+			const float c = i / 255.0f;
+			t.to_linear[i] = c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+		}
+		for (uint32_t i = 0; i < t.to_srgb.size(); ++i)
+		{
+			const float l = i / 4095.0f;
+			const float c = l <= 0.0031308f ? l * 12.92f : 1.055f * std::pow(l, 1.0f / 2.4f) - 0.055f;
+			t.to_srgb[i] = uint32_t(c * 255.0f + 0.5f);
+		}
+		return t;
+	}();
+	return tables;
+}
+
+uint32_t quantize_unorm(float x, float scale)
+{
+	// the comparisons also map nans to zero
+	x = x > 0.0f ? (x < 1.0f ? x : 1.0f) : 0.0f;
+	return uint32_t(x * scale + 0.5f);
+}
+
+uint8_t premultiply(uint32_t c, uint32_t a)
+{
+	// exact round(c * a / 255)
+	const uint32_t t = c * a + 128;
+	return (t + (t >> 8)) >> 8;
+}
+
+// scalar implementations, also used for the remaining pixels of the simd kernels
+
+void rgb8_to_rgba8_scalar(const uint8_t* src, uint8_t* dst, std::size_t pixel_count)
+{
+	for (std::size_t i = 0; i < pixel_count; ++i)
+	{
+		dst[i * 4 + 0] = src[i * 3 + 0];
+		dst[i * 4 + 1] = src[i * 3 + 1];
+		dst[i * 4 + 2] = src[i * 3 + 2];
+		dst[i * 4 + 3] = 255;
+	}
+}
+
+void swizzle_rgba8_scalar(const uint8_t* src, uint8_t* dst, std::size_t pixel_count, std::array<uint8_t, 4> order)
+{
+	for (std::size_t i = 0; i < pixel_count; ++i)
+	{
+		const std::array<uint8_t, 4> pixel = {src[i * 4 + 0], src[i * 4 + 1], src[i * 4 + 2], src[i * 4 + 3]};
+		for (uint32_t j = 0; j < 4; ++j) dst[i * 4 + j] = pixel[order[j]];
+	}
+}
+
+void premultiply_alpha_rgba8_scalar(const uint8_t* src, uint8_t* dst, std::size_t pixel_count)
+{
+	for (std::size_t i = 0; i < pixel_count; ++i)
+	{
+		const uint32_t a = src[i * 4 + 3];
+		dst[i * 4 + 0] = premultiply(src[i * 4 + 0], a);
+		dst[i * 4 + 1] = premultiply(src[i * 4 + 1], a);
+		dst[i * 4 + 2] = premultiply(src[i * 4 + 2], a);
+		dst[i * 4 + 3] = a;
+	}
+}
+
+void premultiply_alpha_rgba32f_scalar(const float* src, float* dst, std::size_t pixel_count)
+{
+	for (std::size_t i = 0; i < pixel_count; ++i)
+	{
+		const float a = src[i * 4 + 3];
+		dst[i * 4 + 0] = src[i * 4 + 0] * a;
+		dst[i * 4 + 1] = src[i * 4 + 1] * a;
+		dst[i * 4 + 2] = src[i * 4 + 2] * a;
+		dst[i * 4 + 3] = a;
+	}
+}
+
+void f32_to_f16_scalar(const float* src, uint16_t* dst, std::size_t count)
+{
+	for (std::size_t i = 0; i < count; ++i) dst[i] = float_to_half(src[i]);
+}
+
+void srgb8_to_linear_rgba32f_scalar(const uint8_t* src, float* dst, std::size_t pixel_count)
+{
+	const SRGBTables& tables = get_srgb_tables();
+	for (std::size_t i = 0; i < pixel_count; ++i)
+	{
+		dst[i * 4 + 0] = tables.to_linear[src[i * 4 + 0]];
+		dst[i * 4 + 1] = tables.to_linear[src[i * 4 + 1]];
+		dst[i * 4 + 2] = tables.to_linear[src[i * 4 + 2]];
+		dst[i * 4 + 3] = src[i * 4 + 3] * (1.0f / 255.0f);
+	}
+}
+
+void linear_rgba32f_to_srgb8_scalar(const float* src, uint8_t* dst, std::size_t pixel_count)
+{
+	const SRGBTables& tables = get_srgb_tables();
+	for (std::size_t i = 0; i < pixel_count; ++i)
+	{
+		dst[i * 4 + 0] = tables.to_srgb[quantize_unorm(src[i * 4 + 0], 4095.0f)];
+		dst[i * 4 + 1] = tables.to_srgb[quantize_unorm(src[i * 4 + 1], 4095.0f)];
+		dst[i * 4 + 2] = tables.to_srgb[quantize_unorm(src[i * 4 + 2], 4095.0f)];
+		dst[i * 4 + 3] = quantize_unorm(src[i * 4 + 3], 255.0f);
+	}
+}
+
+#if VKTE_PIXEL_CONVERSION_X86
+// sse4.1 implementations, 4 pixels per iteration
+
+__attribute__((target("sse4.1"))) void rgb8_to_rgba8_sse4(const uint8_t* src, uint8_t* dst, std::size_t pixel_count)
+{
+	const __m128i mask = _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+	const __m128i alpha = _mm_set1_epi32(0xff000000);
+	std::size_t i = 0;
+	// every load reads 16 bytes of which only 12 are used, so the last pixels must not be loaded this way
+	for (; i + 6 <= pixel_count; i += 4)
+	{
+		const __m128i rgb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 3));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * 4), _mm_or_si128(_mm_shuffle_epi8(rgb, mask), alpha));
+	}
+	rgb8_to_rgba8_scalar(src + i * 3, dst + i * 4, pixel_count - i);
+}
+
+__attribute__((target("sse4.1"))) void swizzle_rgba8_sse4(const uint8_t* src, uint8_t* dst, std::size_t pixel_count, std::array<uint8_t, 4> order)
+{
+	alignas(16) std::array<int8_t, 16> indices;
+	for (uint32_t j = 0; j < 16; ++j) indices[j] = (j & ~3u) + order[j & 3u];
+	const __m128i mask = _mm_load_si128(reinterpret_cast<const __m128i*>(indices.data()));
+	std::size_t i = 0;
+	for (; i + 4 <= pixel_count; i += 4)
+	{
+		const __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 4));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * 4), _mm_shuffle_epi8(pixels, mask));
+	}
+	swizzle_rgba8_scalar(src + i * 4, dst + i * 4, pixel_count - i, order);
+}
+
+__attribute__((target("sse4.1"))) __m128i premultiply_epu16(__m128i c)
+{
+	// broadcast the alpha of each pixel to its 4 lanes, multiply and divide by 255 with rounding, the alpha lanes are restored afterwards
+	const __m128i a = _mm_shufflehi_epi16(_mm_shufflelo_epi16(c, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+	const __m128i t = _mm_add_epi16(_mm_mullo_epi16(c, a), _mm_set1_epi16(128));
+	const __m128i p = _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+	return _mm_blend_epi16(p, c, 0x88);
+}
+
+__attribute__((target("sse4.1"))) void premultiply_alpha_rgba8_sse4(const uint8_t* src, uint8_t* dst, std::size_t pixel_count)
+{
+	std::size_t i = 0;
+	for (; i + 4 <= pixel_count; i += 4)
+	{
+		const __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 4));
+		const __m128i lo = premultiply_epu16(_mm_cvtepu8_epi16(pixels));
+		const __m128i hi = premultiply_epu16(_mm_unpackhi_epi8(pixels, _mm_setzero_si128()));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * 4), _mm_packus_epi16(lo, hi));
+	}
+	premultiply_alpha_rgba8_scalar(src + i * 4, dst + i * 4, pixel_count - i);
+}
+
+__attribute__((target("sse4.1"))) void premultiply_alpha_rgba32f_sse4(const float* src, float* dst, std::size_t pixel_count)
+{
+	for (std::size_t i = 0; i < pixel_count; ++i)
+	{
+		const __m128 pixel = _mm_loadu_ps(src + i * 4);
+		const __m128 a = _mm_shuffle_ps(pixel, pixel, _MM_SHUFFLE(3, 3, 3, 3));
+		_mm_storeu_ps(dst + i * 4, _mm_blend_ps(_mm_mul_ps(pixel, a), pixel, 0x8));
+	}
+}
+
+__attribute__((target("sse4.1"))) void linear_rgba32f_to_srgb8_sse4(const float* src, uint8_t* dst, std::size_t pixel_count)
+{
+	const SRGBTables& tables = get_srgb_tables();
+	const __m128 scale = _mm_setr_ps(4095.0f, 4095.0f, 4095.0f, 255.0f);
+	std::size_t i = 0;
+	for (; i < pixel_count; ++i)
+	{
+		// clamping with max and min in this order also maps nans to zero
+		const __m128 pixel = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(src + i * 4), _mm_setzero_ps()), _mm_set1_ps(1.0f));
+		alignas(16) std::array<uint32_t, 4> q;
+		_mm_store_si128(reinterpret_cast<__m128i*>(q.data()), _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(pixel, scale), _mm_set1_ps(0.5f))));
+		dst[i * 4 + 0] = tables.to_srgb[q[0]];
+		dst[i * 4 + 1] = tables.to_srgb[q[1]];
+		dst[i * 4 + 2] = tables.to_srgb[q[2]];
+		dst[i * 4 + 3] = q[3];
+	}
+}
+
+// avx2 implementations, 8 pixels per iteration
+
+__attribute__((target("avx2"))) void rgb8_to_rgba8_avx2(const uint8_t* src, uint8_t* dst, std::size_t pixel_count)
+{
+	const __m256i mask = _mm256_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1, 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+	const __m256i alpha = _mm256_set1_epi32(0xff000000);
+	std::size_t i = 0;
+	// the second half is loaded from byte 12 on and reads 4 bytes past the 8 pixels
+	for (; i + 10 <= pixel_count; i += 8)
+	{
+		const __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 3));
+		const __m128i hi = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 3 + 12));
+		const __m256i rgb = _mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1);
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i * 4), _mm256_or_si256(_mm256_shuffle_epi8(rgb, mask), alpha));
+	}
+	rgb8_to_rgba8_sse4(src + i * 3, dst + i * 4, pixel_count - i);
+}
+
+__attribute__((target("avx2"))) void swizzle_rgba8_avx2(const uint8_t* src, uint8_t* dst, std::size_t pixel_count, std::array<uint8_t, 4> order)
+{
+	alignas(32) std::array<int8_t, 32> indices;
+	// the shuffle works within 128 bit lanes, so the indices repeat every 16 bytes
+	for (uint32_t j = 0; j < 32; ++j) indices[j] = (j & 12u) + order[j & 3u];
+	const __m256i mask = _mm256_load_si256(reinterpret_cast<const __m256i*>(indices.data()));
+	std::size_t i = 0;
+	for (; i + 8 <= pixel_count; i += 8)
+	{
+		const __m256i pixels = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i * 4));
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i * 4), _mm256_shuffle_epi8(pixels, mask));
+	}
+	swizzle_rgba8_sse4(src + i * 4, dst + i * 4, pixel_count - i, order);
+}
+
+__attribute__((target("avx2"))) __m256i premultiply_epu16_avx2(__m256i c)
+{
+	const __m256i a = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(c, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+	const __m256i t = _mm256_add_epi16(_mm256_mullo_epi16(c, a), _mm256_set1_epi16(128));
+	const __m256i p = _mm256_srli_epi16(_mm256_add_epi16(t, _mm256_srli_epi16(t, 8)), 8);
+	return _mm256_blend_epi16(p, c, 0x88);
+}
+
+__attribute__((target("avx2"))) void premultiply_alpha_rgba8_avx2(const uint8_t* src, uint8_t* dst, std::size_t pixel_count)
+{
+	std::size_t i = 0;
+	for (; i + 8 <= pixel_count; i += 8)
+	{
+		// unpacking and packing both work within 128 bit lanes, so the pixel order is preserved
+		const __m256i pixels = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i * 4));
+		const __m256i lo = premultiply_epu16_avx2(_mm256_unpacklo_epi8(pixels, _mm256_setzero_si256()));
+		const __m256i hi = premultiply_epu16_avx2(_mm256_unpackhi_epi8(pixels, _mm256_setzero_si256()));
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i * 4), _mm256_packus_epi16(lo, hi));
+	}
+	premultiply_alpha_rgba8_sse4(src + i * 4, dst + i * 4, pixel_count - i);
+}
+
+__attribute__((target("avx2"))) void premultiply_alpha_rgba32f_avx2(const float* src, float* dst, std::size_t pixel_count)
+{
+	std::size_t i = 0;
+	for (; i + 2 <= pixel_count; i += 2)
+	{
+		const __m256 pixels = _mm256_loadu_ps(src + i * 4);
+		const __m256 a = _mm256_permute_ps(pixels, _MM_SHUFFLE(3, 3, 3, 3));
+		_mm256_storeu_ps(dst + i * 4, _mm256_blend_ps(_mm256_mul_ps(pixels, a), pixels, 0x88));
+	}
+	premultiply_alpha_rgba32f_sse4(src + i * 4, dst + i * 4, pixel_count - i);
+}
+
+__attribute__((target("avx2,f16c"))) void f32_to_f16_avx2(const float* src, uint16_t* dst, std::size_t count)
+{
+	std::size_t i = 0;
+	for (; i + 8 <= count; i += 8)
+	{
+		const __m128i halfs = _mm256_cvtps_ph(_mm256_loadu_ps(src + i), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), halfs);
+	}
+	f32_to_f16_scalar(src + i, dst + i, count - i);
+}
+
+__attribute__((target("avx2"))) void srgb8_to_linear_rgba32f_avx2(const uint8_t* src, float* dst, std::size_t pixel_count)
+{
+	const SRGBTables& tables = get_srgb_tables();
+	std::size_t i = 0;
+	for (; i + 2 <= pixel_count; i += 2)
+	{
+		const __m256i c = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(src + i * 4)));
+		const __m256 linear = _mm256_i32gather_ps(tables.to_linear.data(), c, 4);
+		const __m256 alpha = _mm256_mul_ps(_mm256_cvtepi32_ps(c), _mm256_set1_ps(1.0f / 255.0f));
+		_mm256_storeu_ps(dst + i * 4, _mm256_blend_ps(linear, alpha, 0x88));
+	}
+	srgb8_to_linear_rgba32f_scalar(src + i * 4, dst + i * 4, pixel_count - i);
+}
+
+__attribute__((target("avx2"))) void linear_rgba32f_to_srgb8_avx2(const float* src, uint8_t* dst, std::size_t pixel_count)
+{
+	const SRGBTables& tables = get_srgb_tables();
+	const __m256 scale = _mm256_setr_ps(4095.0f, 4095.0f, 4095.0f, 255.0f, 4095.0f, 4095.0f, 4095.0f, 255.0f);
+	std::size_t i = 0;
+	for (; i + 2 <= pixel_count; i += 2)
+	{
+		const __m256 pixels = _mm256_min_ps(_mm256_max_ps(_mm256_loadu_ps(src + i * 4), _mm256_setzero_ps()), _mm256_set1_ps(1.0f));
+		const __m256i q = _mm256_cvttps_epi32(_mm256_add_ps(_mm256_mul_ps(pixels, scale), _mm256_set1_ps(0.5f)));
+		const __m256i srgb = _mm256_i32gather_epi32(reinterpret_cast<const int*>(tables.to_srgb.data()), q, 4);
+		const __m256i c = _mm256_blend_epi32(srgb, q, 0x88);
+		const __m128i c16 = _mm_packus_epi32(_mm256_castsi256_si128(c), _mm256_extracti128_si256(c, 1));
+		_mm_storel_epi64(reinterpret_cast<__m128i*>(dst + i * 4), _mm_packus_epi16(c16, c16));
+	}
+	linear_rgba32f_to_srgb8_scalar(src + i * 4, dst + i * 4, pixel_count - i);
+}
+#endif
+
+struct ConversionKernels
+{
+	void (*rgb8_to_rgba8)(const uint8_t*, uint8_t*, std::size_t) = rgb8_to_rgba8_scalar;
+	void (*swizzle_rgba8)(const uint8_t*, uint8_t*, std::size_t, std::array<uint8_t, 4>) = swizzle_rgba8_scalar;
+	void (*premultiply_alpha_rgba8)(const uint8_t*, uint8_t*, std::size_t) = premultiply_alpha_rgba8_scalar;
+	void (*premultiply_alpha_rgba32f)(const float*, float*, std::size_t) = premultiply_alpha_rgba32f_scalar;
+	void (*f32_to_f16)(const float*, uint16_t*, std::size_t) = f32_to_f16_scalar;
+	void (*srgb8_to_linear_rgba32f)(const uint8_t*, float*, std::size_t) = srgb8_to_linear_rgba32f_scalar;
+	void (*linear_rgba32f_to_srgb8)(const float*, uint8_t*, std::size_t) = linear_rgba32f_to_srgb8_scalar;
+};
+
+// the cpu features are only queried once
+const ConversionKernels& get_conversion_kernels()
+{
+	static const ConversionKernels kernels = []() {
+		ConversionKernels k;
+#if VKTE_PIXEL_CONVERSION_X86
+		__builtin_cpu_init();
+		if (__builtin_cpu_supports("sse4.1"))
+		{
+			k.rgb8_to_rgba8 = rgb8_to_rgba8_sse4;
+			k.swizzle_rgba8 = swizzle_rgba8_sse4;
+			k.premultiply_alpha_rgba8 = premultiply_alpha_rgba8_sse4;
+			k.premultiply_alpha_rgba32f = premultiply_alpha_rgba32f_sse4;
+			k.linear_rgba32f_to_srgb8 = linear_rgba32f_to_srgb8_sse4;
+		}
+		if (__builtin_cpu_supports("avx2"))
+		{
+			k.rgb8_to_rgba8 = rgb8_to_rgba8_avx2;
+			k.swizzle_rgba8 = swizzle_rgba8_avx2;
+			k.premultiply_alpha_rgba8 = premultiply_alpha_rgba8_avx2;
+			k.premultiply_alpha_rgba32f = premultiply_alpha_rgba32f_avx2;
+			k.srgb8_to_linear_rgba32f = srgb8_to_linear_rgba32f_avx2;
+			k.linear_rgba32f_to_srgb8 = linear_rgba32f_to_srgb8_avx2;
+			if (__builtin_cpu_supports("f16c")) k.f32_to_f16 = f32_to_f16_avx2;
+		}
+#endif
+		return k;
+	}();
+	return kernels;
+}
+
+void rgb8_to_rgba8(const uint8_t* src, uint8_t* dst, std::size_t pixel_count)
+{
+	get_conversion_kernels().rgb8_to_rgba8(src, dst, pixel_count);
+}
+
+void swizzle_rgba8(const uint8_t* src, uint8_t* dst, std::size_t pixel_count, std::array<uint8_t, 4> order)
+{
+	VKTE_ASSERT(std::all_of(order.begin(), order.end(), [](uint8_t o) { return o < 4; }), "vkte: Invalid swizzle!");
+	get_conversion_kernels().swizzle_rgba8(src, dst, pixel_count, order);
+}
+
+void premultiply_alpha_rgba8(const uint8_t* src, uint8_t* dst, std::size_t pixel_count)
+{
+	get_conversion_kernels().premultiply_alpha_rgba8(src, dst, pixel_count);
+}
+
+void premultiply_alpha_rgba32f(const float* src, float* dst, std::size_t pixel_count)
+{
+	get_conversion_kernels().premultiply_alpha_rgba32f(src, dst, pixel_count);
+}
+
+void f32_to_f16(const float* src, uint16_t* dst, std::size_t count)
+{
+	get_conversion_kernels().f32_to_f16(src, dst, count);
+}
+
+void srgb8_to_linear_rgba32f(const uint8_t* src, float* dst, std::size_t pixel_count)
+{
+	get_conversion_kernels().srgb8_to_linear_rgba32f(src, dst, pixel_count);
+}
+
+void linear_rgba32f_to_srgb8(const float* src, uint8_t* dst, std::size_t pixel_count)
+{
+	get_conversion_kernels().linear_rgba32f_to_srgb8(src, dst, pixel_count);
+}
+
+float srgb8_to_linear(uint8_t c)
+{
+	return get_srgb_tables().to_linear[c];
+}
+
+uint8_t linear_to_srgb8(float l)
+{
+	return get_srgb_tables().to_srgb[quantize_unorm(l, 4095.0f)];
+}
+
+bool is_conversion_valid(PixelConversion conversion, const FormatInfo& format_info)
+{
+	const bool rgba8 = format_info.block_byte_size == 4 && format_info.component_count == 4 && format_info.component_type != ComponentType::Opaque;
+	const bool rgba32f = format_info.block_byte_size == 16 && format_info.component_count == 4 && format_info.component_type == ComponentType::SFloat;
+	switch (conversion)
+	{
+		case PixelConversion::None:
+			return true;
+		case PixelConversion::RGB8ToRGBA8:
+		case PixelConversion::BGRA8ToRGBA8:
+		case PixelConversion::PremultiplyAlphaRGBA8:
+		case PixelConversion::LinearRGBA32FToSRGBA8:
+			return rgba8;
+		case PixelConversion::PremultiplyAlphaRGBA32F:
+		case PixelConversion::SRGBA8ToLinearRGBA32F:
+			return rgba32f;
+		case PixelConversion::F32ToF16:
+			return format_info.component_type == ComponentType::SFloat && format_info.block_byte_size == format_info.component_count * 2;
+	}
+	return false;
+}
+
+uint32_t get_source_texel_byte_size(PixelConversion conversion, const FormatInfo& format_info)
+{
+	switch (conversion)
+	{
+		case PixelConversion::RGB8ToRGBA8:
+			return 3;
+		case PixelConversion::SRGBA8ToLinearRGBA32F:
+			return 4;
+		case PixelConversion::LinearRGBA32FToSRGBA8:
+			return 16;
+		case PixelConversion::F32ToF16:
+			return format_info.block_byte_size * 2;
+		default:
+			return format_info.block_byte_size;
+	}
+}
+
+void convert_pixels(PixelConversion conversion, const unsigned char* src, unsigned char* dst, std::size_t texel_count, const FormatInfo& format_info)
+{
+	switch (conversion)
+	{
+		case PixelConversion::None:
+			memcpy(dst, src, texel_count * format_info.block_byte_size);
+			break;
+		case PixelConversion::RGB8ToRGBA8:
+			rgb8_to_rgba8(src, dst, texel_count);
+			break;
+		case PixelConversion::BGRA8ToRGBA8:
+			swizzle_rgba8(src, dst, texel_count, {2, 1, 0, 3});
+			break;
+		case PixelConversion::PremultiplyAlphaRGBA8:
+			premultiply_alpha_rgba8(src, dst, texel_count);
+			break;
+		case PixelConversion::PremultiplyAlphaRGBA32F:
+			premultiply_alpha_rgba32f(reinterpret_cast<const float*>(src), reinterpret_cast<float*>(dst), texel_count);
+			break;
+		case PixelConversion::F32ToF16:
+			f32_to_f16(reinterpret_cast<const float*>(src), reinterpret_cast<uint16_t*>(dst), texel_count * format_info.component_count);
+			break;
+		case PixelConversion::SRGBA8ToLinearRGBA32F:
+			srgb8_to_linear_rgba32f(src, reinterpret_cast<float*>(dst), texel_count);
+			break;
+		case PixelConversion::LinearRGBA32FToSRGBA8:
+			linear_rgba32f_to_srgb8(reinterpret_cast<const float*>(src), dst, texel_count);
+			break;
+	}
+}
+} // namespace vkte
@@ -36,6 +36,11 @@ std::vector<uint32_t> QueueFamilies::get(Queues queues) const
 		queue_indices.push_back(indices.present);
 		queues &= ~present;
 	}
+	if (queues & QueueFamilyFlags::SparseBinding)
+	{
+		queue_indices.push_back(indices.sparse_binding);
+		queues &= ~sparse_binding;
+	}
 	return queue_indices;
 }
 
@@ -45,6 +50,7 @@ uint32_t QueueFamilies::get(QueueFamilyFlags queue) const
 	else if (queue == QueueFamilyFlags::Compute) return indices.compute;
 	else if (queue == QueueFamilyFlags::Transfer) return indices.transfer;
 	else if (queue == QueueFamilyFlags::Present) return indices.present;
+	else if (queue == QueueFamilyFlags::SparseBinding) return indices.sparse_binding;
 	else VKTE_THROW("vkte: Invalid queue!");
 }
 
@@ -102,6 +108,23 @@ void QueueFamilies::get_queue_families(vk::PhysicalDevice& physical_device, cons
 		}
 	}
 	VKTE_ASSERT(indices.graphics != -1 && indices.compute != -1 && indices.transfer != -1 && indices.present != -1, "vkte: One queue family could not be satisfied!");
+	// binding sparse memory on the graphics queue avoids semaphores between the binding and the rendering
+	if (queue_families[indices.graphics].queueFlags & vk::QueueFlagBits::eSparseBinding)
+	{
+		indices.sparse_binding = indices.graphics;
+	}
+	else
+	{
+		int32_t sparse_binding_score = 0;
+		for (uint32_t i = 0; i < queue_families.size(); ++i)
+		{
+			if (sparse_binding_score < get_queue_score(queue_families[i], vk::QueueFlagBits::eSparseBinding))
+			{
+				sparse_binding_score = get_queue_score(queue_families[i], vk::QueueFlagBits::eSparseBinding);
+				indices.sparse_binding = i;
+			}
+		}
+	}
 	if (indices.graphics == indices.compute)
 	{
 		graphics |= compute;
@@ -132,5 +155,25 @@ void QueueFamilies::get_queue_families(vk::PhysicalDevice& physical_device, cons
 		transfer |= present;
 		present |= transfer;
 	}
+	if (indices.sparse_binding == indices.graphics)
+	{
+		sparse_binding |= graphics;
+		graphics |= sparse_binding;
+	}
+	if (indices.sparse_binding == indices.compute)
+	{
+		sparse_binding |= compute;
+		compute |= sparse_binding;
+	}
+	if (indices.sparse_binding == indices.transfer)
+	{
+		sparse_binding |= transfer;
+		transfer |= sparse_binding;
+	}
+	if (indices.sparse_binding == indices.present)
+	{
+		sparse_binding |= present;
+		present |= sparse_binding;
+	}
 }
 } // namespace vkte
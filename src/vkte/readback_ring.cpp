@@ -0,0 +1,129 @@
+#include "vkte/readback_ring.hpp"
+
+#include "vkte/vkte_log.hpp"
+
+namespace vkte
+{
+ReadbackHandle::ReadbackHandle(ReadbackRing* ring, uint32_t slot, uint64_t generation, vk::DeviceSize byte_size) : ring(ring), slot(slot), generation(generation), byte_size(byte_size)
+{}
+
+bool ReadbackHandle::is_ready() const
+{
+	VKTE_ASSERT(ring != nullptr, "vkte: Invalid readback handle!");
+	const ReadbackRing::Slot& s = ring->slots[slot];
+	return s.generation == generation && ring->is_finished(s);
+}
+
+std::span<const unsigned char> ReadbackHandle::get() const
+{
+	VKTE_ASSERT(ring != nullptr, "vkte: Invalid readback handle!");
+	return ring->read(slot, generation, byte_size);
+}
+
+vk::DeviceSize ReadbackHandle::get_byte_size() const
+{
+	return byte_size;
+}
+
+ReadbackRing::ReadbackRing(const VulkanMainContext& vmc) : vmc(vmc)
+{}
+
+void ReadbackRing::construct(uint32_t slot_count, vk::DeviceSize slot_byte_size)
+{
+	this->slot_byte_size = slot_byte_size;
+	vk::BufferCreateInfo bci;
+	bci.size = slot_byte_size;
+	bci.usage = vk::BufferUsageFlagBits::eTransferDst;
+	bci.sharingMode = vk::SharingMode::eExclusive;
+	// random host access prefers host cached memory, which is much faster to read than write combined memory
+	VmaAllocationCreateInfo vaci{};
+	vaci.usage = VMA_MEMORY_USAGE_AUTO_PREFER_HOST;
+	vaci.flags = VMA_ALLOCATION_CREATE_HOST_ACCESS_RANDOM_BIT | VMA_ALLOCATION_CREATE_MAPPED_BIT;
+	slots.resize(slot_count);
+	for (Slot& slot : slots)
+	{
+		VkBuffer buffer;
+		VmaAllocationInfo alloc_info;
+		vmaCreateBuffer(vmc.va, (VkBufferCreateInfo*) (&bci), &vaci, &buffer, &slot.vmaa, &alloc_info);
+		slot.buffer = buffer;
+		slot.mapped_mem = alloc_info.pMappedData;
+	}
+}
+
+void ReadbackRing::destruct()
+{
+	for (Slot& slot : slots) vmaDestroyBuffer(vmc.va, slot.buffer, slot.vmaa);
+	slots.clear();
+}
+
+std::pair<vk::Buffer, ReadbackHandle> ReadbackRing::acquire(vk::DeviceSize byte_size, vk::Fence fence)
+{
+	Slot& slot = acquire_slot(byte_size);
+	slot.fence = fence;
+	return std::make_pair(slot.buffer, ReadbackHandle(this, uint32_t(&slot - slots.data()), slot.generation, byte_size));
+}
+
+std::pair<vk::Buffer, ReadbackHandle> ReadbackRing::acquire(vk::DeviceSize byte_size, vk::Semaphore timeline, uint64_t timeline_value)
+{
+	Slot& slot = acquire_slot(byte_size);
+	slot.timeline = timeline;
+	slot.timeline_value = timeline_value;
+	return std::make_pair(slot.buffer, ReadbackHandle(this, uint32_t(&slot - slots.data()), slot.generation, byte_size));
+}
+
+vk::DeviceSize ReadbackRing::get_slot_byte_size() const
+{
+	return slot_byte_size;
+}
+
+ReadbackRing::Slot& ReadbackRing::acquire_slot(vk::DeviceSize byte_size)
+{
+	VKTE_ASSERT(!slots.empty(), "vkte: Readback ring is not constructed!");
+	VKTE_ASSERT(byte_size <= slot_byte_size, "vkte: Readback is larger than the slots of the readback ring!");
+	Slot& slot = slots[next_slot];
+	next_slot = (next_slot + 1) % slots.size();
+	// the ring is full, the oldest readback has to finish before its slot can be reused
+	if (slot.pending) wait(slot);
+	slot.generation++;
+	slot.pending = true;
+	slot.fence = nullptr;
+	slot.timeline = nullptr;
+	slot.timeline_value = 0;
+	return slot;
+}
+
+bool ReadbackRing::is_finished(const Slot& slot) const
+{
+	if (!slot.pending) return true;
+	if (slot.fence) return vmc.logical_device.get().getFenceStatus(slot.fence) == vk::Result::eSuccess;
+	return vmc.logical_device.get().getSemaphoreCounterValue(slot.timeline) >= slot.timeline_value;
+}
+
+void ReadbackRing::wait(Slot& slot) const
+{
+	if (!slot.pending) return;
+	if (slot.fence)
+	{
+		VKTE_CHECK(vmc.logical_device.get().waitForFences(slot.fence, VK_TRUE, uint64_t(-1)), "Failed to wait for readback fence!");
+	}
+	else
+	{
+		vk::SemaphoreWaitInfo swi;
+		swi.semaphoreCount = 1;
+		swi.pSemaphores = &slot.timeline;
+		swi.pValues = &slot.timeline_value;
+		VKTE_CHECK(vmc.logical_device.get().waitSemaphores(swi, uint64_t(-1)), "Failed to wait for readback semaphore!");
+	}
+	slot.pending = false;
+}
+
+std::span<const unsigned char> ReadbackRing::read(uint32_t slot_idx, uint64_t generation, vk::DeviceSize byte_size)
+{
+	Slot& slot = slots[slot_idx];
+	VKTE_ASSERT(slot.generation == generation, "vkte: Readback slot was already reused!");
+	wait(slot);
+	// host cached memory is not necessarily coherent
+	vmaInvalidateAllocation(vmc.va, slot.vmaa, 0, byte_size);
+	return std::span<const unsigned char>(static_cast<const unsigned char*>(slot.mapped_mem), byte_size);
+}
+} // namespace vkte
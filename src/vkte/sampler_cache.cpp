@@ -0,0 +1,61 @@
+#include "vkte/sampler_cache.hpp"
+
+#include "vkte/vkte_log.hpp"
+
+namespace vkte
+{
+void SamplerCache::construct(const vk::Device& device)
+{
+	this->device = device;
+}
+
+void SamplerCache::destruct()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	if (!samplers.empty()) VKTE_WARN("vkte: {} sampler(s) not released! Cleaning up...", samplers.size());
+	for (const std::pair<const vk::SamplerCreateInfo, Entry>& sampler : samplers) device.destroySampler(sampler.second.sampler);
+	samplers.clear();
+	sampler_infos.clear();
+}
+
+vk::Sampler SamplerCache::acquire(const vk::SamplerCreateInfo& sci)
+{
+	// the key only covers the create info itself, chained structures would be ignored
+	VKTE_ASSERT(sci.pNext == nullptr, "vkte: Cached samplers do not support pNext chains!");
+	std::lock_guard<std::mutex> lock(mutex);
+	auto it = samplers.find(sci);
+	if (it != samplers.end())
+	{
+		it->second.ref_count++;
+		return it->second.sampler;
+	}
+	vk::Sampler sampler = device.createSampler(sci);
+	samplers.emplace(sci, Entry{sampler, 1});
+	sampler_infos.emplace(sampler, sci);
+	return sampler;
+}
+
+void SamplerCache::release(vk::Sampler sampler)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	auto info = sampler_infos.find(sampler);
+	if (info == sampler_infos.end())
+	{
+		VKTE_ERROR("vkte: Trying to release sampler that is not in the cache!");
+		return;
+	}
+	auto it = samplers.find(info->second);
+	if (--it->second.ref_count == 0)
+	{
+		device.destroySampler(sampler);
+		samplers.erase(it);
+		sampler_infos.erase(info);
+	}
+}
+
+uint32_t SamplerCache::get_sampler_count() const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return samplers.size();
+}
+} // namespace vkte
@@ -0,0 +1,311 @@
+#include "vkte/shader_compiler.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdio>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include "vkte/vkte_log.hpp"
+#if !(defined(WIN32) || defined(_WIN32) || defined(__WIN32__) || defined(__NT__))
+#include <sys/wait.h>
+#endif
+
+namespace vkte
+{
+int run_command(const std::string& command, std::string& output)
+{
+#if defined(WIN32) || defined(_WIN32) || defined(__WIN32__) || defined(__NT__)
+	FILE* pipe = _popen((command + " 2>&1").c_str(), "r");
+#else
+	FILE* pipe = popen((command + " 2>&1").c_str(), "r");
+#endif
+	if (!pipe) return -1;
+	std::array<char, 4096> buffer;
+	std::size_t read_count;
+	while ((read_count = fread(buffer.data(), 1, buffer.size(), pipe)) > 0) output.append(buffer.data(), read_count);
+#if defined(WIN32) || defined(_WIN32) || defined(__WIN32__) || defined(__NT__)
+	return _pclose(pipe);
+#else
+	const int status = pclose(pipe);
+	return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+#endif
+}
+
+struct Compiler
+{
+	std::string command;
+	bool available = false;
+	// output of the version query, part of the hash so that a compiler update invalidates the SPIR-V
+	std::string version;
+};
+
+Compiler query_compiler(const std::string& name, const std::string& version_arg)
+{
+	Compiler compiler;
+	compiler.command = name;
+#if defined(WIN32) || defined(_WIN32) || defined(__WIN32__) || defined(__NT__)
+	compiler.command += ".exe";
+#endif
+	// the version query fails if the compiler is not available
+	compiler.available = run_command(compiler.command + " " + version_arg, compiler.version) == 0;
+	return compiler;
+}
+
+const Compiler& get_compiler(Language lang)
+{
+	// the compilers are queried once per process
+	static const Compiler glslc = query_compiler("glslc", "--version");
+	static const Compiler slangc = query_compiler("slangc", "-v");
+	return lang == Language::Glsl ? glslc : slangc;
+}
+
+std::string get_slang_stage(vk::ShaderStageFlagBits stage_flag)
+{
+	if (stage_flag & vk::ShaderStageFlagBits::eVertex) return "vertex";
+	if (stage_flag & vk::ShaderStageFlagBits::eTessellationControl) return "tesscontrol";
+	if (stage_flag & vk::ShaderStageFlagBits::eTessellationEvaluation) return "tesseval";
+	if (stage_flag & vk::ShaderStageFlagBits::eGeometry) return "geometry";
+	if (stage_flag & vk::ShaderStageFlagBits::eFragment) return "fragment";
+	if (stage_flag & vk::ShaderStageFlagBits::eCompute) return "compute";
+	// Ray tracing stages
+	if (stage_flag & vk::ShaderStageFlagBits::eRaygenKHR) return "raygeneration";
+	if (stage_flag & vk::ShaderStageFlagBits::eIntersectionKHR) return "intersection";
+	if (stage_flag & vk::ShaderStageFlagBits::eAnyHitKHR) return "anyhit";
+	if (stage_flag & vk::ShaderStageFlagBits::eClosestHitKHR) return "closesthit";
+	if (stage_flag & vk::ShaderStageFlagBits::eMissKHR) return "miss";
+	if (stage_flag & vk::ShaderStageFlagBits::eCallableKHR) return "callable";
+	// Mesh shading stages (EXT/NV aliases)
+#ifdef VK_EXT_mesh_shader
+	if (stage_flag & vk::ShaderStageFlagBits::eTaskEXT) return "task";
+	if (stage_flag & vk::ShaderStageFlagBits::eMeshEXT) return "mesh";
+#endif
+#ifdef VK_NV_mesh_shader
+	if (stage_flag & vk::ShaderStageFlagBits::eTaskNV) return "task";
+	if (stage_flag & vk::ShaderStageFlagBits::eMeshNV) return "mesh";
+#endif
+	VKTE_ASSERT(false, "vkte: Unsupported slang shader stage flag");
+	return "";
+}
+
+uint64_t hash_bytes(const void* data, std::size_t byte_count, uint64_t hash)
+{
+	const unsigned char* bytes = static_cast<const unsigned char*>(data);
+	for (std::size_t i = 0; i < byte_count; ++i)
+	{
+		hash ^= bytes[i];
+		hash *= 0x100000001b3ull;
+	}
+	return hash;
+}
+
+uint64_t hash_string(const std::string& str, uint64_t hash)
+{
+	// the size separates consecutive strings
+	const uint64_t size = str.size();
+	return hash_bytes(str.data(), str.size(), hash_bytes(&size, sizeof(size), hash));
+}
+
+// files that a line includes or imports, e.g. #include "common.glsl", import utils.noise;
+std::vector<std::string> get_line_dependencies(const std::string& line, Language lang)
+{
+	std::size_t begin = line.find_first_not_of(" \t");
+	if (begin == std::string::npos) return {};
+	if (line.compare(begin, 8, "#include") == 0)
+	{
+		const std::size_t open = line.find_first_of("\"<", begin + 8);
+		if (open == std::string::npos) return {};
+		const std::size_t close = line.find_first_of("\">", open + 1);
+		if (close == std::string::npos) return {};
+		return {line.substr(open + 1, close - open - 1)};
+	}
+	if (lang != Language::Slang) return {};
+	std::size_t module_begin;
+	if (line.compare(begin, 7, "import ") == 0) module_begin = begin + 7;
+	else if (line.compare(begin, 10, "__include ") == 0) module_begin = begin + 10;
+	else return {};
+	module_begin = line.find_first_not_of(" \t", module_begin);
+	if (module_begin == std::string::npos) return {};
+	const std::size_t module_end = line.find_first_of(" \t;", module_begin);
+	std::string module = line.substr(module_begin, module_end == std::string::npos ? std::string::npos : module_end - module_begin);
+	// quoted imports are file names, otherwise the dots of the module name separate directories
+	if (module.front() == '"') return {module.substr(1, module.find('"', 1) - 1)};
+	std::replace(module.begin(), module.end(), '.', '/');
+	std::string hyphenated = module;
+	// slang also looks for files with hyphens instead of underscores
+	std::replace(hyphenated.begin(), hyphenated.end(), '_', '-');
+	return {module + ".slang", hyphenated + ".slang"};
+}
+
+// hash a file and all of its dependencies, dependencies are looked up relative to the including file and the shader root directory
+uint64_t hash_file(const std::filesystem::path& path, const std::filesystem::path& shader_dir, Language lang, std::unordered_set<std::string>& visited, uint64_t hash)
+{
+	if (!visited.insert(path.lexically_normal().string()).second) return hash;
+	std::ifstream file(path, std::ios::binary);
+	std::ostringstream file_stream;
+	file_stream << file.rdbuf();
+	const std::string content = file_stream.str();
+	hash = hash_string(path.lexically_relative(shader_dir).generic_string(), hash);
+	hash = hash_string(content, hash);
+	std::istringstream lines(content);
+	std::string line;
+	while (std::getline(lines, line))
+	{
+		for (const std::string& dependency : get_line_dependencies(line, lang))
+		{
+			for (const std::filesystem::path& dir : {path.parent_path(), shader_dir})
+			{
+				const std::filesystem::path dependency_path = dir / dependency;
+				if (!std::filesystem::exists(dependency_path)) continue;
+				hash = hash_file(dependency_path, shader_dir, lang, visited, hash);
+				break;
+			}
+		}
+	}
+	return hash;
+}
+
+std::vector<std::string> get_shader_files(const std::string& shader_root_dir, const Shader& shader)
+{
+	const std::filesystem::path shader_dir(shader_root_dir);
+	std::unordered_set<std::string> visited;
+	hash_file(shader_dir / shader.name, shader_dir, shader.lang, visited, hash_offset_basis);
+	return {visited.begin(), visited.end()};
+}
+
+// compilations of the same shader in different batches (e.g. asynchronous constructions and the shader watcher) must not write its SPIR-V at the same time
+std::mutex& get_output_mutex(const std::string& spirv_path)
+{
+	static std::mutex mutex;
+	static std::unordered_map<std::string, std::unique_ptr<std::mutex>> output_mutexes;
+	std::lock_guard<std::mutex> lock(mutex);
+	std::unique_ptr<std::mutex>& output_mutex = output_mutexes[spirv_path];
+	if (!output_mutex) output_mutex = std::make_unique<std::mutex>();
+	return *output_mutex;
+}
+
+ShaderCompileResult compile_shader(const std::string& shader_root_dir, const Shader& shader)
+{
+	std::filesystem::path shader_dir(shader_root_dir);
+	std::filesystem::path shader_bin_dir(shader_dir / "bin/");
+	std::filesystem::path shader_file(shader_dir / shader.name);
+	std::filesystem::path shader_bin_file(shader_bin_dir / (shader.name + ".spv"));
+	// other threads may create the directory at the same time
+	std::error_code error;
+	std::filesystem::create_directories(shader_bin_file.parent_path(), error);
+	std::filesystem::path shader_hash_file(shader_bin_dir / (shader.name + ".spv.hash"));
+	// the compiler writes to a temporary file that replaces the SPIR-V at once, so that it can be read while the shader is compiled
+	std::filesystem::path shader_tmp_file(shader_bin_dir / (shader.name + ".spv.tmp"));
+	ShaderCompileResult result;
+	result.spirv_path = shader_bin_file.string();
+	std::lock_guard<std::mutex> lock(get_output_mutex(result.spirv_path));
+	std::string args;
+	if (shader.lang == Language::Glsl)
+	{
+		args = std::format("--target-env=vulkan1.4 -O -o {0} {1}", shader_tmp_file.string(), shader_file.string());
+	}
+	else if (shader.lang == Language::Slang)
+	{
+		std::string stage = get_slang_stage(shader.stage_flag);
+		// enable all capabilities to prevent any warnings about implicit upgrades
+		args = std::format("-target spirv -emit-spirv-directly -profile spirv_1_5+all -fvk-use-scalar-layout -matrix-layout-column-major -entry main -stage {2} -o {0} {1}", shader_tmp_file.string(), shader_file.string(), stage);
+	}
+	const Compiler& compiler = get_compiler(shader.lang);
+	if (!compiler.available)
+	{
+		if (!std::filesystem::exists(shader_bin_file))
+		{
+			VKTE_ERROR("vkte: Compiler \"{}\" not available and no cached SPIR-V found for shader \"{}\"", compiler.command, shader.name);
+			return result;
+		}
+		VKTE_WARN("vkte: Compiler \"{}\" not available, using cached SPIR-V for shader \"{}\"", compiler.command, shader.name);
+		result.success = true;
+		result.cached = true;
+		return result;
+	}
+	VKTE_ASSERT(std::filesystem::exists(shader_file), "vkte: Failed to find shader file \"" + shader.name + "\"");
+
+	std::unordered_set<std::string> visited;
+	uint64_t hash = hash_string(compiler.version, hash_offset_basis);
+	hash = hash_string(args, hash);
+	hash = hash_file(shader_file, shader_dir, shader.lang, visited, hash);
+	const std::string hash_hex = std::format("{:016x}", hash);
+	if (std::filesystem::exists(shader_bin_file))
+	{
+		std::ifstream file(shader_hash_file);
+		std::string stored_hash;
+		if (file >> stored_hash && stored_hash == hash_hex)
+		{
+			result.success = true;
+			result.cached = true;
+			return result;
+		}
+	}
+
+	// the old SPIR-V stays in place until it is replaced, but it is not up to date anymore
+	if (std::filesystem::exists(shader_hash_file)) std::filesystem::remove(shader_hash_file);
+	if (std::filesystem::exists(shader_tmp_file)) std::filesystem::remove(shader_tmp_file);
+	const int exit_code = run_command(compiler.command + " " + args, result.diagnostics);
+	if (exit_code != 0 || !std::filesystem::exists(shader_tmp_file))
+	{
+		VKTE_ERROR("vkte: Failed to compile shader \"{}\":\n{}", shader.name, result.diagnostics);
+		std::filesystem::remove(shader_tmp_file, error);
+		return result;
+	}
+	std::filesystem::rename(shader_tmp_file, shader_bin_file);
+	if (!result.diagnostics.empty()) VKTE_WARN("vkte: Shader \"{}\":\n{}", shader.name, result.diagnostics);
+	std::ofstream file(shader_hash_file, std::ios::trunc);
+	file << hash_hex;
+	result.success = true;
+	return result;
+}
+
+std::vector<ShaderCompileResult> compile_shaders(const std::string& shader_root_dir, const std::vector<Shader>& shaders, uint32_t job_count)
+{
+	// shaders with the same name write the same SPIR-V file and must not be compiled concurrently
+	std::vector<uint32_t> unique_indices;
+	std::vector<uint32_t> result_indices(shaders.size());
+	std::unordered_map<std::string, uint32_t> name_indices;
+	for (uint32_t i = 0; i < shaders.size(); ++i)
+	{
+		auto [it, inserted] = name_indices.emplace(shaders[i].name, unique_indices.size());
+		if (inserted) unique_indices.push_back(i);
+		result_indices[i] = it->second;
+	}
+
+	std::vector<ShaderCompileResult> unique_results(unique_indices.size());
+	std::atomic<uint32_t> next_idx = 0;
+	auto compile_next = [&]() {
+		for (uint32_t i = next_idx++; i < unique_indices.size(); i = next_idx++)
+		{
+			// exceptions must not leave the worker threads, they are reported as failed compilation
+			try
+			{
+				unique_results[i] = compile_shader(shader_root_dir, shaders[unique_indices[i]]);
+			}
+			catch (const std::exception& e)
+			{
+				unique_results[i].diagnostics = e.what();
+			}
+		}
+	};
+	if (job_count == 0) job_count = std::max(1u, std::thread::hardware_concurrency());
+	// the calling thread compiles too, the compiler processes do the actual work anyway
+	std::vector<std::thread> workers;
+	for (uint32_t i = 1; i < std::min<std::size_t>(job_count, unique_indices.size()); ++i) workers.emplace_back(compile_next);
+	compile_next();
+	for (std::thread& worker : workers) worker.join();
+
+	std::vector<ShaderCompileResult> results;
+	results.reserve(shaders.size());
+	for (uint32_t idx : result_indices) results.push_back(unique_results[idx]);
+	return results;
+}
+} // namespace vkte
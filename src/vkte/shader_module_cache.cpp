@@ -0,0 +1,134 @@
+#include "vkte/shader_module_cache.hpp"
+
+#if defined(WIN32) || defined(_WIN32) || defined(__WIN32__) || defined(__NT__)
+#include <fstream>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+#include "vkte/shader_compiler.hpp"
+#include "vkte/vkte_log.hpp"
+
+namespace vkte
+{
+// map a whole file read only, the SPIR-V is passed to the driver without copying it
+// page aligned, which satisfies the alignment of the SPIR-V words
+const void* map_file(const std::string& path, std::size_t byte_size)
+{
+#if defined(WIN32) || defined(_WIN32) || defined(__WIN32__) || defined(__NT__)
+	std::ifstream file(path, std::ios::binary);
+	if (!file.is_open()) return nullptr;
+	uint32_t* data = new uint32_t[(byte_size + 3) / 4];
+	file.read(reinterpret_cast<char*>(data), byte_size);
+	return data;
+#else
+	const int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+	if (fd < 0) return nullptr;
+	void* data = mmap(nullptr, byte_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	// the mapping stays valid after the file is closed
+	close(fd);
+	return data == MAP_FAILED ? nullptr : data;
+#endif
+}
+
+void unmap_file(const void* data, std::size_t byte_size)
+{
+#if defined(WIN32) || defined(_WIN32) || defined(__WIN32__) || defined(__NT__)
+	delete[] static_cast<const uint32_t*>(data);
+#else
+	munmap(const_cast<void*>(data), byte_size);
+#endif
+}
+
+void ShaderModuleCache::construct(const vk::Device& device)
+{
+	this->device = device;
+}
+
+void ShaderModuleCache::destruct()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	if (!modules.empty()) VKTE_WARN("vkte: {} shader module(s) not released! Cleaning up...", modules.size());
+	for (const std::pair<const Key, Entry>& module : modules) device.destroyShaderModule(module.second.module);
+	modules.clear();
+	module_keys.clear();
+	file_states.clear();
+}
+
+vk::ShaderModule ShaderModuleCache::acquire(const std::string& spirv_path, uint64_t& spirv_hash)
+{
+	std::error_code error;
+	const std::filesystem::file_time_type write_time = std::filesystem::last_write_time(spirv_path, error);
+	const std::uintmax_t byte_size = error ? 0 : std::filesystem::file_size(spirv_path, error);
+	VKTE_ASSERT(!error && byte_size > 0, "vkte: Failed to open shader file \"" + spirv_path + "\"");
+
+	std::lock_guard<std::mutex> lock(mutex);
+	// an unchanged file has the same hash, so it does not have to be read again
+	auto file_state = file_states.find(spirv_path);
+	if (file_state != file_states.end() && file_state->second.write_time == write_time && file_state->second.byte_size == byte_size)
+	{
+		auto it = modules.find(Key(spirv_path, file_state->second.hash));
+		if (it != modules.end())
+		{
+			it->second.ref_count++;
+			spirv_hash = file_state->second.hash;
+			return it->second.module;
+		}
+	}
+
+	const void* data = map_file(spirv_path, byte_size);
+	VKTE_ASSERT(data, "vkte: Failed to map shader file \"" + spirv_path + "\"");
+	spirv_hash = hash_bytes(data, byte_size);
+	file_states[spirv_path] = FileState{write_time, byte_size, spirv_hash};
+	auto it = modules.find(Key(spirv_path, spirv_hash));
+	if (it != modules.end())
+	{
+		unmap_file(data, byte_size);
+		it->second.ref_count++;
+		return it->second.module;
+	}
+	vk::ShaderModuleCreateInfo smci;
+	smci.codeSize = byte_size;
+	smci.pCode = static_cast<const uint32_t*>(data);
+	vk::ShaderModule module;
+	try
+	{
+		module = device.createShaderModule(smci);
+	}
+	catch (...)
+	{
+		unmap_file(data, byte_size);
+		throw;
+	}
+	unmap_file(data, byte_size);
+	modules.emplace(Key(spirv_path, spirv_hash), Entry{module, 1});
+	module_keys.emplace(module, Key(spirv_path, spirv_hash));
+	return module;
+}
+
+void ShaderModuleCache::release(vk::ShaderModule module)
+{
+	if (!module) return;
+	std::lock_guard<std::mutex> lock(mutex);
+	auto key = module_keys.find(module);
+	if (key == module_keys.end())
+	{
+		VKTE_ERROR("vkte: Trying to release shader module that is not in the cache!");
+		return;
+	}
+	auto it = modules.find(key->second);
+	if (--it->second.ref_count == 0)
+	{
+		device.destroyShaderModule(module);
+		modules.erase(it);
+		module_keys.erase(key);
+	}
+}
+
+uint32_t ShaderModuleCache::get_module_count() const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return modules.size();
+}
+} // namespace vkte
@@ -0,0 +1,222 @@
+#include "vkte/shader_watcher.hpp"
+
+#include <algorithm>
+#include <filesystem>
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+#include "vkte/shader_compiler.hpp"
+#include "vkte/vkte_log.hpp"
+
+namespace vkte
+{
+// editors often write a file in multiple steps, changes are collected until no event arrived for this long
+constexpr int settle_time_ms = 50;
+// interval in which the watcher thread checks whether it should stop
+constexpr int stop_poll_interval_ms = 100;
+
+ShaderWatcher::ShaderWatcher(const VulkanMainContext& vmc) : vmc(vmc)
+{}
+
+void ShaderWatcher::construct(uint32_t frames_in_flight)
+{
+	this->frames_in_flight = frames_in_flight;
+	frame = 0;
+#ifdef __linux__
+	inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	VKTE_ASSERT(inotify_fd >= 0, "vkte: Failed to initialize inotify!");
+	stop = false;
+	thread = std::thread(&ShaderWatcher::run, this);
+#else
+	VKTE_WARN("vkte: Shader hot reload is only supported on linux");
+#endif
+}
+
+void ShaderWatcher::destruct()
+{
+	stop = true;
+	if (thread.joinable()) thread.join();
+#ifdef __linux__
+	if (inotify_fd >= 0) close(inotify_fd);
+#endif
+	inotify_fd = -1;
+	for (RebuiltPipeline& r : rebuilt_pipelines) r.rebuilt->destruct();
+	rebuilt_pipelines.clear();
+	destroy_retired_pipelines(true);
+	pipelines.clear();
+	watched_dirs.clear();
+}
+
+void ShaderWatcher::add_pipeline(Pipeline& pipeline)
+{
+	std::unordered_set<std::string> files = get_files(pipeline);
+	std::lock_guard<std::mutex> lock(mutex);
+	watch(files);
+	pipelines[&pipeline] = std::move(files);
+}
+
+void ShaderWatcher::remove_pipeline(Pipeline& pipeline)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	pipelines.erase(&pipeline);
+	std::erase_if(rebuilt_pipelines, [&](RebuiltPipeline& r) {
+		if (r.pipeline != &pipeline) return false;
+		r.rebuilt->destruct();
+		return true;
+	});
+}
+
+std::vector<Pipeline*> ShaderWatcher::update()
+{
+	frame++;
+	destroy_retired_pipelines(false);
+	// the watcher thread copies the settings of registered pipelines under the lock, swap() exchanges them
+	std::lock_guard<std::mutex> lock(mutex);
+	std::vector<Pipeline*> swapped;
+	for (RebuiltPipeline& r : rebuilt_pipelines)
+	{
+		// afterwards the rebuilt pipeline holds the old state, which frames in flight may still use
+		r.pipeline->swap(*r.rebuilt);
+		retired_pipelines.push_back({std::move(r.rebuilt), frame});
+		swapped.push_back(r.pipeline);
+	}
+	rebuilt_pipelines.clear();
+	return swapped;
+}
+
+std::unordered_set<std::string> ShaderWatcher::get_files(Pipeline& pipeline) const
+{
+	std::vector<Shader> shaders;
+	if (pipeline.get_type() == Pipeline::Type::Graphics) shaders = pipeline.get_graphics_settings().shaders;
+	else shaders = {pipeline.get_compute_settings().shader};
+	std::unordered_set<std::string> files;
+	for (const Shader& shader : shaders)
+	{
+		for (std::string& file : get_shader_files(vmc.shader_root_dir, shader)) files.insert(std::move(file));
+	}
+	return files;
+}
+
+void ShaderWatcher::watch(const std::unordered_set<std::string>& files)
+{
+#ifdef __linux__
+	// directories are watched instead of files, as editors often replace a file instead of writing it
+	for (const std::string& file : files)
+	{
+		const std::string dir = std::filesystem::path(file).parent_path().string();
+		const int wd = inotify_add_watch(inotify_fd, dir.empty() ? "." : dir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+		if (wd < 0) VKTE_WARN("vkte: Failed to watch shader directory \"{}\"", dir);
+		else watched_dirs[wd] = dir;
+	}
+#endif
+}
+
+void ShaderWatcher::run()
+{
+#ifdef __linux__
+	while (!stop)
+	{
+		pollfd pfd{inotify_fd, POLLIN, 0};
+		if (poll(&pfd, 1, stop_poll_interval_ms) <= 0) continue;
+		std::unordered_set<std::string> changed_files;
+		do
+		{
+			std::unordered_set<std::string> files = read_changed_files();
+			changed_files.insert(files.begin(), files.end());
+		}
+		while (!stop && poll(&pfd, 1, settle_time_ms) > 0);
+
+		std::vector<Pipeline*> changed_pipelines;
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			for (const auto& [pipeline, files] : pipelines)
+			{
+				if (std::any_of(changed_files.begin(), changed_files.end(), [&](const std::string& file) { return files.contains(file); })) changed_pipelines.push_back(pipeline);
+			}
+		}
+		for (Pipeline* pipeline : changed_pipelines)
+		{
+			if (stop) break;
+			rebuild(pipeline);
+		}
+	}
+#endif
+}
+
+std::unordered_set<std::string> ShaderWatcher::read_changed_files()
+{
+	std::unordered_set<std::string> changed_files;
+#ifdef __linux__
+	alignas(inotify_event) char buffer[4096];
+	ssize_t length;
+	while ((length = read(inotify_fd, buffer, sizeof(buffer))) > 0)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		for (ssize_t offset = 0; offset < length;)
+		{
+			const inotify_event* event = reinterpret_cast<const inotify_event*>(buffer + offset);
+			offset += sizeof(inotify_event) + event->len;
+			auto dir = watched_dirs.find(event->wd);
+			if (event->len == 0 || dir == watched_dirs.end()) continue;
+			// same form as the paths of get_shader_files()
+			changed_files.insert((std::filesystem::path(dir->second) / event->name).lexically_normal().string());
+		}
+	}
+#endif
+	return changed_files;
+}
+
+void ShaderWatcher::rebuild(Pipeline* pipeline)
+{
+	std::unique_ptr<Pipeline> rebuilt;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		if (!pipelines.contains(pipeline)) return;
+		rebuilt = std::make_unique<Pipeline>(vmc, pipeline->get_type());
+		if (pipeline->get_type() == Pipeline::Type::Graphics) rebuilt->get_graphics_settings() = pipeline->get_graphics_settings();
+		else rebuilt->get_compute_settings() = pipeline->get_compute_settings();
+	}
+	// includes may have been added or removed
+	std::unordered_set<std::string> files = get_files(*rebuilt);
+	bool success = false;
+	try
+	{
+		// a single compiler process keeps the impact on the frame rate low
+		success = rebuilt->compile_shaders(1);
+		if (success) rebuilt->construct();
+	}
+	catch (const std::exception& e)
+	{
+		VKTE_ERROR("vkte: Failed to rebuild pipeline: {}", e.what());
+		success = false;
+	}
+
+	std::lock_guard<std::mutex> lock(mutex);
+	watch(files);
+	if (!success || !pipelines.contains(pipeline))
+	{
+		rebuilt->destruct();
+		return;
+	}
+	pipelines[pipeline] = std::move(files);
+	// a rebuild that was not swapped in yet is outdated
+	std::erase_if(rebuilt_pipelines, [&](RebuiltPipeline& r) {
+		if (r.pipeline != pipeline) return false;
+		r.rebuilt->destruct();
+		return true;
+	});
+	rebuilt_pipelines.push_back({pipeline, std::move(rebuilt)});
+	VKTE_INFO("vkte: Rebuilt pipeline after a shader change");
+}
+
+void ShaderWatcher::destroy_retired_pipelines(bool all)
+{
+	std::erase_if(retired_pipelines, [&](RetiredPipeline& r) {
+		if (!all && frame - r.frame < frames_in_flight) return false;
+		r.pipeline->destruct();
+		return true;
+	});
+}
+} // namespace vkte
@@ -0,0 +1,214 @@
+#include "vkte/sparse_image.hpp"
+
+#include <algorithm>
+#include "vkte/vkte_log.hpp"
+
+namespace vkte
+{
+SparseImage::SparseImage(const VulkanMainContext& vmc, const VulkanCommandContext& vcc, uint32_t width, uint32_t height, vk::Format format, vk::ImageUsageFlags usage, bool use_mip_maps, Queues queues) :
+	vmc(vmc), image(vmc, vcc, width, height, usage, format, vk::SampleCountFlagBits::e1, use_mip_maps, 0, queues, true, 1, vk::ImageCreateFlagBits::eSparseBinding | vk::ImageCreateFlagBits::eSparseResidency), mip_levels(image.get_full_range().level_count)
+{
+	VKTE_ASSERT(vmc.get_features().device_features.sparse_residency, "vkte: Sparse residency is not enabled!");
+	VKTE_ASSERT(!vmc.physical_device.get().getSparseImageFormatProperties(format, vk::ImageType::e2D, vk::SampleCountFlagBits::e1, usage, vk::ImageTiling::eOptimal).empty(), "vkte: Format " + vk::to_string(format) + " does not support sparse residency!");
+
+	const vk::MemoryRequirements memory_requirements = vmc.logical_device.get().getImageMemoryRequirements(image.get_image());
+	// the size of one sparse block is given by the alignment
+	tile_byte_size = memory_requirements.alignment;
+	const std::vector<vk::SparseImageMemoryRequirements> sparse_requirements = vmc.logical_device.get().getImageSparseMemoryRequirements(image.get_image());
+	auto color_requirements = std::find_if(sparse_requirements.begin(), sparse_requirements.end(), [](const vk::SparseImageMemoryRequirements& r) { return bool(r.formatProperties.aspectMask & vk::ImageAspectFlagBits::eColor); });
+	VKTE_ASSERT(color_requirements != sparse_requirements.end(), "vkte: Sparse image has no color aspect requirements!");
+	tile_extent = color_requirements->formatProperties.imageGranularity;
+	mip_tail_first_level = std::min(color_requirements->imageMipTailFirstLod, mip_levels);
+
+	// all pages come from a pool of the memory type that the image supports
+	VmaAllocationCreateInfo vaci{};
+	vaci.requiredFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+	uint32_t memory_type_idx;
+	VKTE_CHECK(vk::Result(vmaFindMemoryTypeIndex(vmc.va, memory_requirements.memoryTypeBits, &vaci, &memory_type_idx)), "No memory type for sparse image found!");
+	VmaPoolCreateInfo vpci{};
+	vpci.memoryTypeIndex = memory_type_idx;
+	VKTE_CHECK(vk::Result(vmaCreatePool(vmc.va, &vpci, &pool)), "Failed to create memory pool for sparse image!");
+
+	page_table.resize(mip_tail_first_level);
+	for (uint32_t i = 0; i < mip_tail_first_level; ++i) page_table[i].assign(std::size_t(get_tile_count_x(i)) * get_tile_count_y(i), VK_NULL_HANDLE);
+
+	// the mip tail and the metadata can not be bound per tile, they are bound once and stay resident
+	for (const vk::SparseImageMemoryRequirements& r : sparse_requirements)
+	{
+		if (r.imageMipTailFirstLod < mip_levels || (r.formatProperties.aspectMask & vk::ImageAspectFlagBits::eMetadata)) bind_mip_tail(r, memory_requirements);
+	}
+}
+
+void SparseImage::bind_mip_tail(const vk::SparseImageMemoryRequirements& requirements, const vk::MemoryRequirements& memory_requirements)
+{
+	VmaAllocationCreateInfo vaci{};
+	vaci.pool = pool;
+	VkMemoryRequirements mr = memory_requirements;
+	mr.size = requirements.imageMipTailSize;
+	VmaAllocation allocation;
+	VmaAllocationInfo allocation_info;
+	VKTE_CHECK(vk::Result(vmaAllocateMemory(vmc.va, &mr, &vaci, &allocation, &allocation_info)), "Failed to allocate mip tail of sparse image!");
+	mip_tail_allocations.push_back(allocation);
+
+	vk::SparseMemoryBind bind;
+	bind.resourceOffset = requirements.imageMipTailOffset;
+	bind.size = requirements.imageMipTailSize;
+	bind.memory = allocation_info.deviceMemory;
+	bind.memoryOffset = allocation_info.offset;
+	if (requirements.formatProperties.aspectMask & vk::ImageAspectFlagBits::eMetadata) bind.flags = vk::SparseMemoryBindFlagBits::eMetadata;
+	pending_opaque_binds.push_back(bind);
+}
+
+void SparseImage::destruct()
+{
+	free_finished_pages(true);
+	for (std::vector<VmaAllocation>& level : page_table)
+	{
+		for (VmaAllocation allocation : level)
+		{
+			if (allocation) vmaFreeMemory(vmc.va, allocation);
+		}
+	}
+	for (VmaAllocation allocation : mip_tail_allocations) vmaFreeMemory(vmc.va, allocation);
+	for (VmaAllocation allocation : pending_frees) vmaFreeMemory(vmc.va, allocation);
+	page_table.clear();
+	mip_tail_allocations.clear();
+	pending_frees.clear();
+	pending_binds.clear();
+	pending_opaque_binds.clear();
+	image.destruct();
+	vmaDestroyPool(vmc.va, pool);
+}
+
+void SparseImage::make_resident(uint32_t mip_level, uint32_t tile_x, uint32_t tile_y)
+{
+	if (mip_level >= mip_tail_first_level) return;
+	VKTE_ASSERT(tile_x < get_tile_count_x(mip_level) && tile_y < get_tile_count_y(mip_level), "vkte: Tile is outside of the sparse image!");
+	VmaAllocation& page = page_table[mip_level][tile_y * get_tile_count_x(mip_level) + tile_x];
+	if (page) return;
+
+	VmaAllocationCreateInfo vaci{};
+	vaci.pool = pool;
+	VkMemoryRequirements mr{};
+	mr.size = tile_byte_size;
+	mr.alignment = tile_byte_size;
+	mr.memoryTypeBits = ~0u;
+	VmaAllocationInfo allocation_info;
+	VKTE_CHECK(vk::Result(vmaAllocateMemory(vmc.va, &mr, &vaci, &page, &allocation_info)), "Failed to allocate sparse image page!");
+	resident_tile_count++;
+
+	const uint32_t level_width = std::max(1u, image.get_extent().width >> mip_level);
+	const uint32_t level_height = std::max(1u, image.get_extent().height >> mip_level);
+	vk::SparseImageMemoryBind bind;
+	bind.subresource = vk::ImageSubresource(vk::ImageAspectFlagBits::eColor, mip_level, 0);
+	bind.offset = vk::Offset3D(tile_x * tile_extent.width, tile_y * tile_extent.height, 0);
+	// tiles at the border of the level are cut to the level extent
+	bind.extent = vk::Extent3D(std::min(tile_extent.width, level_width - bind.offset.x), std::min(tile_extent.height, level_height - bind.offset.y), 1);
+	bind.memory = allocation_info.deviceMemory;
+	bind.memoryOffset = allocation_info.offset;
+	add_pending_bind(bind);
+}
+
+void SparseImage::make_non_resident(uint32_t mip_level, uint32_t tile_x, uint32_t tile_y)
+{
+	if (mip_level >= mip_tail_first_level) return;
+	VKTE_ASSERT(tile_x < get_tile_count_x(mip_level) && tile_y < get_tile_count_y(mip_level), "vkte: Tile is outside of the sparse image!");
+	VmaAllocation& page = page_table[mip_level][tile_y * get_tile_count_x(mip_level) + tile_x];
+	if (!page) return;
+
+	const uint32_t level_width = std::max(1u, image.get_extent().width >> mip_level);
+	const uint32_t level_height = std::max(1u, image.get_extent().height >> mip_level);
+	vk::SparseImageMemoryBind bind;
+	bind.subresource = vk::ImageSubresource(vk::ImageAspectFlagBits::eColor, mip_level, 0);
+	bind.offset = vk::Offset3D(tile_x * tile_extent.width, tile_y * tile_extent.height, 0);
+	bind.extent = vk::Extent3D(std::min(tile_extent.width, level_width - bind.offset.x), std::min(tile_extent.height, level_height - bind.offset.y), 1);
+	bind.memory = VK_NULL_HANDLE;
+	add_pending_bind(bind);
+	pending_frees.push_back(page);
+	page = VK_NULL_HANDLE;
+	resident_tile_count--;
+}
+
+void SparseImage::add_pending_bind(const vk::SparseImageMemoryBind& bind)
+{
+	// a range must not be bound more than once in a batch, so a later change of the same tile replaces the pending one
+	auto it = std::find_if(pending_binds.begin(), pending_binds.end(), [&](const vk::SparseImageMemoryBind& b) { return b.subresource == bind.subresource && b.offset == bind.offset; });
+	if (it != pending_binds.end()) *it = bind;
+	else pending_binds.push_back(bind);
+}
+
+bool SparseImage::is_resident(uint32_t mip_level, uint32_t tile_x, uint32_t tile_y) const
+{
+	if (mip_level >= mip_tail_first_level) return true;
+	return page_table[mip_level][tile_y * get_tile_count_x(mip_level) + tile_x] != VK_NULL_HANDLE;
+}
+
+void SparseImage::submit_binds(const std::vector<vk::Semaphore>& wait_semaphores, const std::vector<vk::Semaphore>& signal_semaphores)
+{
+	free_finished_pages(false);
+	if (!has_pending_binds()) return;
+
+	vk::SparseImageMemoryBindInfo image_bind_info(image.get_image(), pending_binds);
+	vk::SparseImageOpaqueMemoryBindInfo opaque_bind_info(image.get_image(), pending_opaque_binds);
+	vk::BindSparseInfo bind_info;
+	bind_info.setWaitSemaphores(wait_semaphores);
+	bind_info.setSignalSemaphores(signal_semaphores);
+	if (!pending_binds.empty()) bind_info.setImageBinds(image_bind_info);
+	if (!pending_opaque_binds.empty()) bind_info.setImageOpaqueBinds(opaque_bind_info);
+	// the fence tells when the unbound pages can be freed
+	InFlightBinds in_flight{vmc.logical_device.get().createFence({}), std::move(pending_frees)};
+	vmc.get_sparse_binding_queue().bindSparse(bind_info, in_flight.fence);
+	in_flight_binds.push_back(std::move(in_flight));
+	pending_binds.clear();
+	pending_opaque_binds.clear();
+	pending_frees.clear();
+}
+
+bool SparseImage::has_pending_binds() const
+{
+	return !pending_binds.empty() || !pending_opaque_binds.empty();
+}
+
+void SparseImage::free_finished_pages(bool wait)
+{
+	std::erase_if(in_flight_binds, [&](InFlightBinds& in_flight) {
+		if (wait) VKTE_CHECK(vmc.logical_device.get().waitForFences(in_flight.fence, VK_TRUE, uint64_t(-1)), "Failed to wait for sparse binding fence!");
+		else if (vmc.logical_device.get().getFenceStatus(in_flight.fence) != vk::Result::eSuccess) return false;
+		for (VmaAllocation allocation : in_flight.frees) vmaFreeMemory(vmc.va, allocation);
+		vmc.logical_device.get().destroyFence(in_flight.fence);
+		return true;
+	});
+}
+
+vk::Extent3D SparseImage::get_tile_extent() const
+{
+	return tile_extent;
+}
+
+uint32_t SparseImage::get_tile_count_x(uint32_t mip_level) const
+{
+	const uint32_t level_width = std::max(1u, image.get_extent().width >> mip_level);
+	return (level_width + tile_extent.width - 1) / tile_extent.width;
+}
+
+uint32_t SparseImage::get_tile_count_y(uint32_t mip_level) const
+{
+	const uint32_t level_height = std::max(1u, image.get_extent().height >> mip_level);
+	return (level_height + tile_extent.height - 1) / tile_extent.height;
+}
+
+uint32_t SparseImage::get_mip_tail_first_level() const
+{
+	return mip_tail_first_level;
+}
+
+uint32_t SparseImage::get_resident_tile_count() const
+{
+	return resident_tile_count;
+}
+
+Image& SparseImage::get_image()
+{
+	return image;
+}
+} // namespace vkte
@@ -0,0 +1,413 @@
+#include "vkte/spirv_reflection.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <map>
+#include <tuple>
+#include "vkte/vkte_log.hpp"
+
+namespace vkte
+{
+// values of the SPIR-V specification that the reflection needs
+constexpr uint32_t spirv_magic = 0x07230203;
+constexpr uint32_t spirv_version_1_4 = 0x00010400;
+constexpr uint32_t op_entry_point = 15;
+constexpr uint32_t op_execution_mode = 16;
+constexpr uint32_t op_type_bool = 20;
+constexpr uint32_t op_type_int = 21;
+constexpr uint32_t op_type_float = 22;
+constexpr uint32_t op_type_vector = 23;
+constexpr uint32_t op_type_matrix = 24;
+constexpr uint32_t op_type_image = 25;
+constexpr uint32_t op_type_sampler = 26;
+constexpr uint32_t op_type_sampled_image = 27;
+constexpr uint32_t op_type_array = 28;
+constexpr uint32_t op_type_runtime_array = 29;
+constexpr uint32_t op_type_struct = 30;
+constexpr uint32_t op_type_pointer = 32;
+constexpr uint32_t op_constant = 43;
+constexpr uint32_t op_constant_composite = 44;
+constexpr uint32_t op_spec_constant = 50;
+constexpr uint32_t op_spec_constant_composite = 51;
+constexpr uint32_t op_variable = 59;
+constexpr uint32_t op_decorate = 71;
+constexpr uint32_t op_member_decorate = 72;
+constexpr uint32_t op_execution_mode_id = 331;
+constexpr uint32_t op_type_acceleration_structure = 5341;
+constexpr uint32_t decoration_block = 2;
+constexpr uint32_t decoration_buffer_block = 3;
+constexpr uint32_t decoration_row_major = 4;
+constexpr uint32_t decoration_array_stride = 6;
+constexpr uint32_t decoration_matrix_stride = 7;
+constexpr uint32_t decoration_built_in = 11;
+constexpr uint32_t decoration_binding = 33;
+constexpr uint32_t decoration_descriptor_set = 34;
+constexpr uint32_t decoration_offset = 35;
+constexpr uint32_t built_in_workgroup_size = 25;
+constexpr uint32_t execution_mode_local_size = 17;
+constexpr uint32_t execution_mode_local_size_id = 38;
+constexpr uint32_t storage_class_uniform_constant = 0;
+constexpr uint32_t storage_class_uniform = 2;
+constexpr uint32_t storage_class_push_constant = 9;
+constexpr uint32_t storage_class_storage_buffer = 12;
+constexpr uint32_t dim_buffer = 5;
+constexpr uint32_t dim_subpass_data = 6;
+constexpr uint32_t no_value = std::numeric_limits<uint32_t>::max();
+
+struct SpirvModule
+{
+	struct Decorations
+	{
+		uint32_t set = 0;
+		uint32_t binding = 0;
+		bool block = false;
+		bool buffer_block = false;
+		uint32_t array_stride = 0;
+		uint32_t built_in = no_value;
+		std::vector<uint32_t> member_offsets;
+		std::vector<uint32_t> member_matrix_strides;
+		std::vector<bool> member_row_major;
+	};
+
+	// instruction that defines each id, the first word contains the opcode
+	std::vector<const uint32_t*> definitions;
+	std::vector<Decorations> decorations;
+	std::vector<uint32_t> variables;
+	// global variables that the entry point uses, only listed completely since SPIR-V 1.4
+	std::vector<uint32_t> interface;
+	bool has_interface = false;
+	std::array<uint32_t, 3> local_size = {1, 1, 1};
+	std::array<uint32_t, 3> local_size_ids = {no_value, no_value, no_value};
+
+	const uint32_t* get(uint32_t id) const
+	{
+		VKTE_ASSERT(id < definitions.size() && definitions[id], "vkte: SPIR-V references an undefined id!");
+		return definitions[id];
+	}
+
+	uint32_t get_constant(uint32_t id) const
+	{
+		const uint32_t* constant = get(id);
+		VKTE_ASSERT((constant[0] & 0xffff) == op_constant || (constant[0] & 0xffff) == op_spec_constant, "vkte: SPIR-V array length or local size is not a constant!");
+		return constant[3];
+	}
+};
+
+// grow the member decorations of a struct to hold the given member
+template<typename T>
+typename std::vector<T>::reference get_member(std::vector<T>& members, uint32_t member)
+{
+	if (members.size() <= member) members.resize(member + 1);
+	return members[member];
+}
+
+SpirvModule parse_spirv(const uint32_t* code, std::size_t word_count)
+{
+	VKTE_ASSERT(word_count >= 5 && code[0] == spirv_magic, "vkte: Invalid SPIR-V header!");
+	SpirvModule module;
+	const uint32_t version = code[1];
+	const uint32_t bound = code[3];
+	module.definitions.assign(bound, nullptr);
+	module.decorations.resize(bound);
+	bool entry_point_found = false;
+	for (std::size_t i = 5; i < word_count;)
+	{
+		const uint32_t* inst = code + i;
+		const uint32_t opcode = inst[0] & 0xffff;
+		const uint32_t length = inst[0] >> 16;
+		VKTE_ASSERT(length > 0 && i + length <= word_count, "vkte: Invalid SPIR-V instruction!");
+		auto define = [&](uint32_t id) {
+			VKTE_ASSERT(id < bound, "vkte: SPIR-V id is out of bounds!");
+			module.definitions[id] = inst;
+		};
+		switch (opcode)
+		{
+		case op_entry_point:
+			// the first entry point is reflected, the name is a null terminated string padded to whole words
+			if (entry_point_found) break;
+			entry_point_found = true;
+			if (version >= spirv_version_1_4)
+			{
+				const uint32_t name_word_count = uint32_t(strnlen(reinterpret_cast<const char*>(inst + 3), (length - 3) * 4) / 4 + 1);
+				module.interface.assign(inst + 3 + name_word_count, inst + length);
+				module.has_interface = true;
+			}
+			break;
+		case op_execution_mode:
+			if (inst[2] == execution_mode_local_size && length >= 6) module.local_size = {inst[3], inst[4], inst[5]};
+			break;
+		case op_execution_mode_id:
+			if (inst[2] == execution_mode_local_size_id && length >= 6) module.local_size_ids = {inst[3], inst[4], inst[5]};
+			break;
+		case op_decorate:
+		{
+			VKTE_ASSERT(inst[1] < bound, "vkte: SPIR-V id is out of bounds!");
+			SpirvModule::Decorations& d = module.decorations[inst[1]];
+			const uint32_t operand = length > 3 ? inst[3] : 0;
+			if (inst[2] == decoration_descriptor_set) d.set = operand;
+			else if (inst[2] == decoration_binding) d.binding = operand;
+			else if (inst[2] == decoration_block) d.block = true;
+			else if (inst[2] == decoration_buffer_block) d.buffer_block = true;
+			else if (inst[2] == decoration_array_stride) d.array_stride = operand;
+			else if (inst[2] == decoration_built_in) d.built_in = operand;
+			break;
+		}
+		case op_member_decorate:
+		{
+			VKTE_ASSERT(inst[1] < bound, "vkte: SPIR-V id is out of bounds!");
+			SpirvModule::Decorations& d = module.decorations[inst[1]];
+			const uint32_t operand = length > 4 ? inst[4] : 0;
+			if (inst[3] == decoration_offset) get_member(d.member_offsets, inst[2]) = operand;
+			else if (inst[3] == decoration_matrix_stride) get_member(d.member_matrix_strides, inst[2]) = operand;
+			else if (inst[3] == decoration_row_major) get_member(d.member_row_major, inst[2]) = true;
+			break;
+		}
+		case op_type_bool:
+		case op_type_int:
+		case op_type_float:
+		case op_type_vector:
+		case op_type_matrix:
+		case op_type_image:
+		case op_type_sampler:
+		case op_type_sampled_image:
+		case op_type_array:
+		case op_type_runtime_array:
+		case op_type_struct:
+		case op_type_pointer:
+		case op_type_acceleration_structure:
+			define(inst[1]);
+			break;
+		case op_constant:
+		case op_constant_composite:
+		case op_spec_constant:
+		case op_spec_constant_composite:
+			define(inst[2]);
+			break;
+		case op_variable:
+			define(inst[2]);
+			module.variables.push_back(inst[2]);
+			break;
+		}
+		i += length;
+	}
+	return module;
+}
+
+// byte size of a type in a block with explicit layout, runtime arrays have a size of 0
+uint32_t get_type_size(const SpirvModule& module, uint32_t type_id, uint32_t matrix_stride, bool row_major)
+{
+	const uint32_t* type = module.get(type_id);
+	switch (type[0] & 0xffff)
+	{
+	case op_type_bool:
+		return 4;
+	case op_type_int:
+	case op_type_float:
+		return type[2] / 8;
+	case op_type_vector:
+		return type[3] * get_type_size(module, type[2], 0, false);
+	case op_type_matrix:
+	{
+		// the stride is between columns, or between rows for row major matrices
+		const uint32_t* column = module.get(type[2]);
+		const uint32_t count = row_major ? column[3] : type[3];
+		return count * (matrix_stride > 0 ? matrix_stride : get_type_size(module, type[2], 0, false));
+	}
+	case op_type_array:
+	{
+		const uint32_t stride = module.decorations[type_id].array_stride;
+		return module.get_constant(type[3]) * (stride > 0 ? stride : get_type_size(module, type[2], matrix_stride, row_major));
+	}
+	case op_type_runtime_array:
+		return 0;
+	case op_type_struct:
+	{
+		const SpirvModule::Decorations& d = module.decorations[type_id];
+		uint32_t size = 0;
+		for (uint32_t i = 0; i + 2 < (type[0] >> 16); ++i)
+		{
+			const uint32_t offset = i < d.member_offsets.size() ? d.member_offsets[i] : 0;
+			const uint32_t member_matrix_stride = i < d.member_matrix_strides.size() ? d.member_matrix_strides[i] : 0;
+			const bool member_row_major = i < d.member_row_major.size() && d.member_row_major[i];
+			size = std::max(size, offset + get_type_size(module, type[2 + i], member_matrix_stride, member_row_major));
+		}
+		return size;
+	}
+	case op_type_pointer:
+		// physical storage buffer pointers
+		return 8;
+	}
+	VKTE_THROW("vkte: Unsupported type in SPIR-V block!");
+	return 0;
+}
+
+// returns false if the variable is not a descriptor
+bool get_descriptor_type(const SpirvModule& module, uint32_t storage_class, uint32_t type_id, vk::DescriptorType& type)
+{
+	const uint32_t* t = module.get(type_id);
+	if (storage_class == storage_class_uniform)
+	{
+		type = module.decorations[type_id].buffer_block ? vk::DescriptorType::eStorageBuffer : vk::DescriptorType::eUniformBuffer;
+		return true;
+	}
+	if (storage_class == storage_class_storage_buffer)
+	{
+		type = vk::DescriptorType::eStorageBuffer;
+		return true;
+	}
+	if (storage_class != storage_class_uniform_constant) return false;
+	switch (t[0] & 0xffff)
+	{
+	case op_type_sampler:
+		type = vk::DescriptorType::eSampler;
+		return true;
+	case op_type_sampled_image:
+		type = vk::DescriptorType::eCombinedImageSampler;
+		return true;
+	case op_type_image:
+		// the sampled operand is 1 for images that are used with a sampler and 2 for storage images
+		if (t[3] == dim_buffer) type = t[7] == 2 ? vk::DescriptorType::eStorageTexelBuffer : vk::DescriptorType::eUniformTexelBuffer;
+		else if (t[3] == dim_subpass_data) type = vk::DescriptorType::eInputAttachment;
+		else type = t[7] == 2 ? vk::DescriptorType::eStorageImage : vk::DescriptorType::eSampledImage;
+		return true;
+	case op_type_acceleration_structure:
+		type = vk::DescriptorType::eAccelerationStructureKHR;
+		return true;
+	}
+	return false;
+}
+
+ShaderReflection reflect_spirv(const uint32_t* code, std::size_t word_count, vk::ShaderStageFlagBits stage)
+{
+	const SpirvModule module = parse_spirv(code, word_count);
+	ShaderReflection reflection;
+	uint32_t push_constant_begin = no_value;
+	uint32_t push_constant_end = 0;
+	for (uint32_t id : module.variables)
+	{
+		if (module.has_interface && std::find(module.interface.begin(), module.interface.end(), id) == module.interface.end()) continue;
+		const uint32_t* variable = module.get(id);
+		const uint32_t storage_class = variable[3];
+		const uint32_t* pointer = module.get(variable[1]);
+		uint32_t type_id = pointer[3];
+
+		if (storage_class == storage_class_push_constant)
+		{
+			// only the members up to the last one are part of the range, a block may start at an offset to share the push constants between stages
+			const uint32_t* block = module.get(type_id);
+			const SpirvModule::Decorations& d = module.decorations[type_id];
+			for (uint32_t i = 0; i + 2 < (block[0] >> 16); ++i)
+			{
+				const uint32_t offset = i < d.member_offsets.size() ? d.member_offsets[i] : 0;
+				const uint32_t member_matrix_stride = i < d.member_matrix_strides.size() ? d.member_matrix_strides[i] : 0;
+				const bool member_row_major = i < d.member_row_major.size() && d.member_row_major[i];
+				push_constant_begin = std::min(push_constant_begin, offset);
+				push_constant_end = std::max(push_constant_end, offset + get_type_size(module, block[2 + i], member_matrix_stride, member_row_major));
+			}
+			continue;
+		}
+
+		uint32_t descriptor_count = 1;
+		const uint32_t* type = module.get(type_id);
+		if ((type[0] & 0xffff) == op_type_array)
+		{
+			descriptor_count = module.get_constant(type[3]);
+			type_id = type[2];
+		}
+		else if ((type[0] & 0xffff) == op_type_runtime_array)
+		{
+			descriptor_count = 0;
+			type_id = type[2];
+		}
+		vk::DescriptorType descriptor_type;
+		if (!get_descriptor_type(module, storage_class, type_id, descriptor_type)) continue;
+		const SpirvModule::Decorations& d = module.decorations[id];
+		reflection.bindings.push_back({d.set, d.binding, descriptor_type, descriptor_count, stage});
+	}
+	std::sort(reflection.bindings.begin(), reflection.bindings.end(), [](const ShaderReflection::Binding& a, const ShaderReflection::Binding& b) { return std::tie(a.set, a.binding) < std::tie(b.set, b.binding); });
+	if (push_constant_end > 0) reflection.push_constant_ranges.push_back(vk::PushConstantRange(stage, push_constant_begin, push_constant_end - push_constant_begin));
+
+	if (stage == vk::ShaderStageFlagBits::eCompute)
+	{
+		// the values are the defaults of the specialization constants if the local size is specialized
+		reflection.local_size = module.local_size;
+		if (module.local_size_ids[0] != no_value)
+		{
+			for (uint32_t i = 0; i < 3; ++i) reflection.local_size[i] = module.get_constant(module.local_size_ids[i]);
+		}
+		// a constant decorated as the workgroup size overrides the execution mode
+		for (uint32_t id = 0; id < module.definitions.size(); ++id)
+		{
+			if (module.decorations[id].built_in != built_in_workgroup_size || !module.definitions[id]) continue;
+			const uint32_t* composite = module.definitions[id];
+			for (uint32_t i = 0; i < 3; ++i) reflection.local_size[i] = module.get_constant(composite[3 + i]);
+		}
+	}
+	return reflection;
+}
+
+ShaderReflection reflect_spirv_file(const std::string& spirv_path, vk::ShaderStageFlagBits stage)
+{
+	std::ifstream file(spirv_path, std::ios::binary | std::ios::ate);
+	VKTE_ASSERT(file.is_open(), "vkte: Failed to open shader file \"" + spirv_path + "\"");
+	std::vector<uint32_t> code(std::size_t(file.tellg()) / sizeof(uint32_t));
+	file.seekg(0);
+	file.read(reinterpret_cast<char*>(code.data()), code.size() * sizeof(uint32_t));
+	return reflect_spirv(code.data(), code.size(), stage);
+}
+
+ShaderReflection merge_reflections(const std::vector<ShaderReflection>& reflections)
+{
+	ShaderReflection merged;
+	std::map<std::pair<uint32_t, uint32_t>, ShaderReflection::Binding> bindings;
+	for (const ShaderReflection& reflection : reflections)
+	{
+		for (const ShaderReflection::Binding& binding : reflection.bindings)
+		{
+			auto [it, inserted] = bindings.emplace(std::make_pair(binding.set, binding.binding), binding);
+			if (inserted) continue;
+			VKTE_ASSERT(it->second.type == binding.type, "vkte: Shader stages use different descriptor types for set " + std::to_string(binding.set) + " binding " + std::to_string(binding.binding) + "!");
+			it->second.stages |= binding.stages;
+			// a runtime array in any stage makes the binding a runtime array
+			if (binding.descriptor_count == 0 || it->second.descriptor_count == 0) it->second.descriptor_count = 0;
+			else it->second.descriptor_count = std::max(it->second.descriptor_count, binding.descriptor_count);
+		}
+		// every stage keeps its own range, so that no stage gets access to push constants it does not declare
+		for (const vk::PushConstantRange& pcr : reflection.push_constant_ranges)
+		{
+			auto it = std::find_if(merged.push_constant_ranges.begin(), merged.push_constant_ranges.end(), [&](const vk::PushConstantRange& r) { return r.stageFlags == pcr.stageFlags; });
+			if (it == merged.push_constant_ranges.end())
+			{
+				merged.push_constant_ranges.push_back(pcr);
+				continue;
+			}
+			const uint32_t end = std::max(it->offset + it->size, pcr.offset + pcr.size);
+			it->offset = std::min(it->offset, pcr.offset);
+			it->size = end - it->offset;
+		}
+		if (reflection.local_size != std::array<uint32_t, 3>{1, 1, 1}) merged.local_size = reflection.local_size;
+	}
+	for (const std::pair<const std::pair<uint32_t, uint32_t>, ShaderReflection::Binding>& binding : bindings) merged.bindings.push_back(binding.second);
+	return merged;
+}
+
+uint32_t ShaderReflection::get_set_count() const
+{
+	uint32_t set_count = 0;
+	for (const Binding& binding : bindings) set_count = std::max(set_count, binding.set + 1);
+	return set_count;
+}
+
+std::vector<vk::DescriptorSetLayoutBinding> ShaderReflection::get_layout_bindings(uint32_t set) const
+{
+	std::vector<vk::DescriptorSetLayoutBinding> layout_bindings;
+	for (const Binding& binding : bindings)
+	{
+		if (binding.set != set) continue;
+		layout_bindings.push_back(vk::DescriptorSetLayoutBinding(binding.binding, binding.type, binding.descriptor_count == 0 ? runtime_array_descriptor_count : binding.descriptor_count, binding.stages));
+	}
+	return layout_bindings;
+}
+} // namespace vkte
@@ -0,0 +1,259 @@
+#include "vkte/texture_streamer.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include "vkte/format_info.hpp"
+#include "vkte/vkte_log.hpp"
+
+namespace vkte
+{
+// number of frames a texture keeps a finer level after it was last requested, avoids uploading the same level over and over again
+constexpr uint64_t coarsen_delay = 120;
+// fraction of the heap budget reported by vma above which textures get evicted
+constexpr double heap_pressure_threshold = 0.9;
+constexpr uint32_t no_request = std::numeric_limits<uint32_t>::max();
+
+TextureStreamer::TextureStreamer(const VulkanMainContext& vmc, VulkanCommandContext& vcc, Storage& storage) : vmc(vmc), vcc(vcc), storage(storage)
+{}
+
+void TextureStreamer::construct(uint32_t frames_in_flight, uint32_t max_texture_count, vk::DeviceSize upload_budget, vk::DeviceSize memory_budget)
+{
+	this->frames_in_flight = frames_in_flight;
+	this->max_texture_count = max_texture_count;
+	this->upload_budget = upload_budget;
+	this->memory_budget = memory_budget;
+	for (uint32_t i = 0; i < frames_in_flight; ++i)
+	{
+		feedback_buffers.emplace_back(vmc, vcc, std::size_t(max_texture_count) * sizeof(uint32_t), vk::BufferUsageFlagBits::eStorageBuffer, false, QueueFamilyFlags::Graphics);
+		// no level sampled yet
+		feedback_buffers.back().update_data_bytes(0xff, std::size_t(max_texture_count) * sizeof(uint32_t));
+	}
+}
+
+void TextureStreamer::destruct()
+{
+	destroy_retired_images(true);
+	for (Texture& texture : textures) storage.destroy_image(texture.storage_idx);
+	textures.clear();
+	for (Buffer& buffer : feedback_buffers) buffer.destruct();
+	feedback_buffers.clear();
+	resident_byte_size = 0;
+}
+
+uint32_t TextureStreamer::add_texture(const std::string& name, std::vector<unsigned char> data, vk::Format format, uint32_t width, uint32_t height, vk::ImageUsageFlags usage_flags, Queues queues, uint32_t min_resident_extent)
+{
+	VKTE_ASSERT(textures.size() < max_texture_count, "vkte: Too many streamed textures!");
+	VKTE_ASSERT(get_format_info(format).component_type != ComponentType::Opaque, "vkte: Streamed textures need a format that can be downsampled on the cpu!");
+	VKTE_ASSERT(data.size() >= get_image_byte_size(format, width, height), "vkte: Texture contains less data than required!");
+	Texture texture{
+		.name = name,
+		.data = std::move(data),
+		.format = format,
+		.width = width,
+		.height = height,
+		.usage_flags = usage_flags,
+		.queues = queues,
+		.mip_level_count = uint32_t(std::floor(std::log2(std::max(width, height)))) + 1
+	};
+	texture.coarsest_level = 0;
+	while ((std::max(width, height) >> texture.coarsest_level) > min_resident_extent && texture.coarsest_level + 1 < texture.mip_level_count) texture.coarsest_level++;
+	texture.resident_level = texture.coarsest_level;
+	texture.requested_level = no_request;
+	texture.wanted_level = texture.coarsest_level;
+	texture.storage_idx = storage.add_image(get_image_name(texture, texture.resident_level), static_cast<const void*>(texture.data.data()), texture.format, texture.width, texture.height, true, texture.resident_level, texture.queues, texture.usage_flags);
+	resident_byte_size += get_byte_size(texture, texture.resident_level);
+	textures.push_back(std::move(texture));
+	return textures.size() - 1;
+}
+
+void TextureStreamer::request_screen_size(uint32_t texture_id, float screen_width, float screen_height)
+{
+	const Texture& texture = textures.at(texture_id);
+	// one texel per pixel is sufficient, every halving of the covered pixels allows one coarser level
+	const float ratio = std::max(texture.width / std::max(screen_width, 1.0f), texture.height / std::max(screen_height, 1.0f));
+	request_mip_level(texture_id, ratio > 1.0f ? uint32_t(std::floor(std::log2(ratio))) : 0);
+}
+
+void TextureStreamer::request_mip_level(uint32_t texture_id, uint32_t mip_level)
+{
+	Texture& texture = textures.at(texture_id);
+	texture.requested_level = std::min(texture.requested_level, mip_level);
+}
+
+const Buffer& TextureStreamer::get_feedback_buffer(uint32_t frame_index) const
+{
+	return feedback_buffers.at(frame_index);
+}
+
+std::vector<uint32_t> TextureStreamer::update(uint32_t frame_index)
+{
+	frame++;
+	destroy_retired_images(false);
+	read_feedback(frame_index);
+
+	for (Texture& texture : textures)
+	{
+		const uint32_t requested_level = std::min(texture.requested_level, texture.coarsest_level);
+		// finer levels are wanted immediately, coarser levels only once the finer level was not requested for a while
+		if (requested_level <= texture.wanted_level)
+		{
+			texture.wanted_level = requested_level;
+			if (texture.requested_level != no_request) texture.last_requested_frame = frame;
+		}
+		else if (frame - texture.last_requested_frame > coarsen_delay)
+		{
+			texture.wanted_level = requested_level;
+		}
+		texture.requested_level = no_request;
+	}
+
+	std::vector<uint32_t> changed_textures;
+	// textures that miss the most levels are uploaded first
+	std::vector<uint32_t> upload_order;
+	for (uint32_t i = 0; i < textures.size(); ++i)
+	{
+		if (textures[i].wanted_level < textures[i].resident_level) upload_order.push_back(i);
+	}
+	std::sort(upload_order.begin(), upload_order.end(), [&](uint32_t a, uint32_t b) { return textures[a].resident_level - textures[a].wanted_level > textures[b].resident_level - textures[b].wanted_level; });
+	vk::DeviceSize remaining_upload_budget = upload_budget;
+	const bool batched = vcc.is_upload_batch_open();
+	if (!upload_order.empty() && !batched) vcc.begin_upload_batch();
+	for (uint32_t id : upload_order)
+	{
+		Texture& texture = textures[id];
+		// use the finest level that fits into the budgets, the first upload may exceed the upload budget by one level so that large textures are not starved
+		uint32_t level = texture.wanted_level;
+		const vk::DeviceSize current_byte_size = get_byte_size(texture, texture.resident_level);
+		while (level < texture.resident_level && (get_byte_size(texture, level) > remaining_upload_budget || resident_byte_size - current_byte_size + get_byte_size(texture, level) > memory_budget)) level++;
+		if (level == texture.resident_level && remaining_upload_budget == upload_budget && resident_byte_size - current_byte_size + get_byte_size(texture, level - 1) <= memory_budget) level--;
+		if (level == texture.resident_level) continue;
+		const vk::DeviceSize byte_size = get_byte_size(texture, level);
+		remaining_upload_budget -= std::min(byte_size, remaining_upload_budget);
+		make_resident(texture, level);
+		changed_textures.push_back(id);
+		if (remaining_upload_budget == 0) break;
+	}
+	if (!upload_order.empty() && !batched) vcc.submit_upload_batch();
+
+	// evict the levels that are not wanted anymore, the textures that were not requested for the longest time first
+	while (is_memory_pressure())
+	{
+		auto evictable = [&](const Texture& t) { return t.resident_level < t.wanted_level; };
+		auto texture = std::min_element(textures.begin(), textures.end(), [&](const Texture& a, const Texture& b) {
+			if (evictable(a) != evictable(b)) return evictable(a);
+			if ((a.resident_level < a.coarsest_level) != (b.resident_level < b.coarsest_level)) return a.resident_level < a.coarsest_level;
+			return a.last_requested_frame < b.last_requested_frame;
+		});
+		if (texture == textures.end() || texture->resident_level >= texture->coarsest_level) break;
+		// wanted levels are dropped entirely, otherwise the texture gets one level coarser
+		const uint32_t level = evictable(*texture) ? texture->wanted_level : texture->resident_level + 1;
+		if (!evictable(*texture)) texture->wanted_level = level;
+		if (!vcc.is_upload_batch_open()) vcc.begin_upload_batch();
+		make_resident(*texture, level);
+		changed_textures.push_back(texture - textures.begin());
+	}
+	if (vcc.is_upload_batch_open() && !batched) vcc.submit_upload_batch();
+
+	std::sort(changed_textures.begin(), changed_textures.end());
+	changed_textures.erase(std::unique(changed_textures.begin(), changed_textures.end()), changed_textures.end());
+	return changed_textures;
+}
+
+Image& TextureStreamer::get_image(uint32_t texture_id)
+{
+	return storage.get_image(textures.at(texture_id).storage_idx);
+}
+
+uint32_t TextureStreamer::get_resident_mip_level(uint32_t texture_id) const
+{
+	return textures.at(texture_id).resident_level;
+}
+
+uint32_t TextureStreamer::get_mip_level_count(uint32_t texture_id) const
+{
+	return textures.at(texture_id).mip_level_count;
+}
+
+vk::DeviceSize TextureStreamer::get_resident_byte_size() const
+{
+	return resident_byte_size;
+}
+
+vk::DeviceSize TextureStreamer::get_byte_size(const Texture& texture, uint32_t level) const
+{
+	vk::DeviceSize byte_size = 0;
+	for (uint32_t i = level; i < texture.mip_level_count; ++i) byte_size += get_image_byte_size(texture.format, std::max(1u, texture.width >> i), std::max(1u, texture.height >> i));
+	return byte_size;
+}
+
+std::string TextureStreamer::get_image_name(const Texture& texture, uint32_t level) const
+{
+	return texture.name + "#" + std::to_string(level);
+}
+
+void TextureStreamer::read_feedback(uint32_t frame_index)
+{
+	if (textures.empty()) return;
+	Buffer& feedback_buffer = feedback_buffers.at(frame_index);
+	const std::vector<uint32_t> feedback = feedback_buffer.obtain_data<uint32_t>(textures.size());
+	for (uint32_t i = 0; i < textures.size(); ++i)
+	{
+		if (feedback[i] == no_request) continue;
+		// the reported level is relative to the resident level of the image that was sampled
+		const int64_t level = int64_t(textures[i].resident_level) + int64_t(feedback[i]) - int64_t(feedback_lod_bias);
+		request_mip_level(i, uint32_t(std::max<int64_t>(level, 0)));
+	}
+	feedback_buffer.update_data_bytes(0xff, textures.size() * sizeof(uint32_t));
+}
+
+void TextureStreamer::make_resident(Texture& texture, uint32_t level)
+{
+	const std::string name = get_image_name(texture, level);
+	uint32_t storage_idx;
+	// an image of this level that was replaced recently can be used again without uploading it
+	auto retired = std::find_if(retired_images.begin(), retired_images.end(), [&](const RetiredImage& r) { return r.name == name; });
+	if (retired != retired_images.end())
+	{
+		storage_idx = retired->storage_idx;
+		retired_images.erase(retired);
+	}
+	else
+	{
+		storage_idx = storage.add_image(name, static_cast<const void*>(texture.data.data()), texture.format, texture.width, texture.height, true, level, texture.queues, texture.usage_flags);
+	}
+	const vk::DeviceSize old_byte_size = get_byte_size(texture, texture.resident_level);
+	retired_images.push_back({get_image_name(texture, texture.resident_level), texture.storage_idx, old_byte_size, frame});
+	resident_byte_size = resident_byte_size - old_byte_size + get_byte_size(texture, level);
+	texture.resident_level = level;
+	texture.storage_idx = storage_idx;
+}
+
+void TextureStreamer::destroy_retired_images(bool all)
+{
+	std::erase_if(retired_images, [&](const RetiredImage& r) {
+		if (!all && frame - r.frame < frames_in_flight) return false;
+		storage.destroy_image(r.storage_idx);
+		return true;
+	});
+}
+
+bool TextureStreamer::is_memory_pressure() const
+{
+	if (resident_byte_size > memory_budget) return true;
+	const VkPhysicalDeviceMemoryProperties* memory_properties;
+	vmaGetMemoryProperties(vmc.va, &memory_properties);
+	std::vector<VmaBudget> budgets(memory_properties->memoryHeapCount);
+	vmaGetHeapBudgets(vmc.va, budgets.data());
+	// retired images are freed within the next frames, so they do not count as pressure, otherwise evicting would only increase the usage
+	vk::DeviceSize retired_byte_size = 0;
+	for (const RetiredImage& r : retired_images) retired_byte_size += r.byte_size;
+	for (uint32_t i = 0; i < memory_properties->memoryHeapCount; ++i)
+	{
+		if (!(memory_properties->memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT)) continue;
+		const vk::DeviceSize usage = budgets[i].usage - std::min<vk::DeviceSize>(budgets[i].usage, retired_byte_size);
+		if (usage > budgets[i].budget * heap_pressure_threshold) return true;
+	}
+	return false;
+}
+} // namespace vkte
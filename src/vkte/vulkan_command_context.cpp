@@ -1,5 +1,7 @@
 #include "vkte/vulkan_command_context.hpp"
 
+#include "vkte/vkte_log.hpp"
+
 namespace vkte
 {
 VulkanCommandContext::VulkanCommandContext(const VulkanMainContext& vmc) : vmc(vmc), command_pools(TYPE_COUNT), one_time_cbs(TYPE_COUNT)
@@ -13,6 +15,7 @@ void VulkanCommandContext::construct()
 	one_time_cbs[GRAPHICS] = command_pools[GRAPHICS].create_command_buffers(1)[0];
 	one_time_cbs[COMPUTE] = command_pools[COMPUTE].create_command_buffers(1)[0];
 	one_time_cbs[TRANSFER] = command_pools[TRANSFER].create_command_buffers(1)[0];
+	upload_cb = command_pools[GRAPHICS].create_command_buffers(1)[0];
 }
 
 void VulkanCommandContext::destruct()
@@ -68,6 +71,38 @@ void VulkanCommandContext::submit_transfer(const vk::CommandBuffer& cb, bool wai
 	submit(cb, vmc.get_transfer_queue(), wait_idle);
 }
 
+void VulkanCommandContext::begin_upload_batch()
+{
+	VKTE_ASSERT(!upload_batch_open, "vkte: Upload batch is already open!");
+	begin(upload_cb);
+	upload_batch_open = true;
+}
+
+void VulkanCommandContext::submit_upload_batch()
+{
+	VKTE_ASSERT(upload_batch_open, "vkte: No upload batch to submit!");
+	submit(upload_cb, vmc.get_graphics_queue(), true);
+	upload_batch_open = false;
+	for (std::function<void()>& cleanup : upload_cleanups) cleanup();
+	upload_cleanups.clear();
+}
+
+bool VulkanCommandContext::is_upload_batch_open() const
+{
+	return upload_batch_open;
+}
+
+vk::CommandBuffer& VulkanCommandContext::get_upload_buffer()
+{
+	VKTE_ASSERT(upload_batch_open, "vkte: No upload batch open!");
+	return upload_cb;
+}
+
+void VulkanCommandContext::defer_until_upload_submitted(std::function<void()> cleanup)
+{
+	upload_cleanups.push_back(std::move(cleanup));
+}
+
 void VulkanCommandContext::submit(const vk::CommandBuffer& cb, const vk::Queue& queue, bool wait_idle) const
 {
 	cb.end();
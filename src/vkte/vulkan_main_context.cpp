@@ -1,5 +1,6 @@
 #include "vkte/vulkan_main_context.hpp"
 
+#include <filesystem>
 #include "vkte/vkte_log.hpp"
 #define VMA_STATIC_VULKAN_FUNCTIONS 0
 #define VMA_DYNAMIC_VULKAN_FUNCTIONS 1
@@ -54,10 +55,21 @@ void VulkanMainContext::construct(const std::string& title, const uint32_t width
 	}
 	if (features.device_features.ray_query) device_extensions.push_back(VK_KHR_RAY_QUERY_EXTENSION_NAME);
 	if (features.device_features.dynamic_polygon_mode) device_extensions.push_back(VK_EXT_EXTENDED_DYNAMIC_STATE_3_EXTENSION_NAME);
+	if (features.device_features.graphics_pipeline_library)
+	{
+		device_extensions.push_back(VK_KHR_PIPELINE_LIBRARY_EXTENSION_NAME);
+		device_extensions.push_back(VK_EXT_GRAPHICS_PIPELINE_LIBRARY_EXTENSION_NAME);
+	}
+	if (features.device_features.shader_object) device_extensions.push_back(VK_EXT_SHADER_OBJECT_EXTENSION_NAME);
 	physical_device.construct(instance, device_extensions, surface);
 	queue_families.construct(physical_device.get(), surface);
 	logical_device.construct(physical_device, features.device_features, queue_families, queues);
 	VULKAN_HPP_DEFAULT_DISPATCHER.init(logical_device.get());
+	sampler_cache.construct(logical_device.get());
+	pipeline_cache.construct(logical_device.get(), physical_device.get(), (std::filesystem::path(shader_root_dir) / "bin" / "pipeline_cache.bin").string());
+	pipeline_library_cache.construct(logical_device.get());
+	shader_module_cache.construct(logical_device.get());
+	descriptor_set_layout_cache.construct(logical_device.get());
 	create_vma_allocator();
 	setup_debug_messenger();
 	window.show();
@@ -83,10 +95,21 @@ void VulkanMainContext::construct(const Features& features, const std::string& s
 	}
 	if (features.device_features.ray_query) device_extensions.push_back(VK_KHR_RAY_QUERY_EXTENSION_NAME);
 	if (features.device_features.dynamic_polygon_mode) device_extensions.push_back(VK_EXT_EXTENDED_DYNAMIC_STATE_3_EXTENSION_NAME);
+	if (features.device_features.graphics_pipeline_library)
+	{
+		device_extensions.push_back(VK_KHR_PIPELINE_LIBRARY_EXTENSION_NAME);
+		device_extensions.push_back(VK_EXT_GRAPHICS_PIPELINE_LIBRARY_EXTENSION_NAME);
+	}
+	if (features.device_features.shader_object) device_extensions.push_back(VK_EXT_SHADER_OBJECT_EXTENSION_NAME);
 	physical_device.construct(instance, device_extensions, std::nullopt);
 	queue_families.construct(physical_device.get(), {});
 	logical_device.construct(physical_device, features.device_features, queue_families, queues);
 	VULKAN_HPP_DEFAULT_DISPATCHER.init(logical_device.get());
+	sampler_cache.construct(logical_device.get());
+	pipeline_cache.construct(logical_device.get(), physical_device.get(), (std::filesystem::path(shader_root_dir) / "bin" / "pipeline_cache.bin").string());
+	pipeline_library_cache.construct(logical_device.get());
+	shader_module_cache.construct(logical_device.get());
+	descriptor_set_layout_cache.construct(logical_device.get());
 	create_vma_allocator();
 	setup_debug_messenger();
 }
@@ -95,6 +118,11 @@ void VulkanMainContext::construct(const Features& features, const std::string& s
 
 void VulkanMainContext::destruct()
 {
+	descriptor_set_layout_cache.destruct();
+	shader_module_cache.destruct();
+	pipeline_library_cache.destruct();
+	pipeline_cache.destruct();
+	sampler_cache.destruct();
 	vmaDestroyAllocator(va);
 	instance.get().destroySurfaceKHR(surface);
 	logical_device.destruct();
@@ -142,6 +170,12 @@ const vk::Queue& VulkanMainContext::get_present_queue() const
 	return queues.at(QueueIndex::Present);
 }
 
+const vk::Queue& VulkanMainContext::get_sparse_binding_queue() const
+{
+	VKTE_ASSERT(features.device_features.sparse_residency, "vkte: Sparse residency is not enabled!");
+	return queues.at(QueueIndex::SparseBinding);
+}
+
 const Features& VulkanMainContext::get_features() const
 {
 	return features;
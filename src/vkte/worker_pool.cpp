@@ -0,0 +1,45 @@
+#include "vkte/worker_pool.hpp"
+
+#include <algorithm>
+
+namespace vkte
+{
+void WorkerPool::construct(uint32_t thread_count)
+{
+	if (thread_count == 0) thread_count = std::max(1u, std::thread::hardware_concurrency());
+	stop = false;
+	for (uint32_t i = 0; i < thread_count; ++i)
+	{
+		threads.emplace_back([this]() {
+			while (true)
+			{
+				std::function<void()> job;
+				{
+					std::unique_lock<std::mutex> lock(mutex);
+					cv.wait(lock, [this]() { return stop || !jobs.empty(); });
+					if (jobs.empty()) return;
+					job = std::move(jobs.front());
+					jobs.pop();
+				}
+				job();
+			}
+		});
+	}
+}
+
+void WorkerPool::destruct()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stop = true;
+	}
+	cv.notify_all();
+	for (std::thread& thread : threads) thread.join();
+	threads.clear();
+}
+
+uint32_t WorkerPool::get_thread_count() const
+{
+	return threads.size();
+}
+} // namespace vkte